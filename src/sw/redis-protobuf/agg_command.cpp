@@ -0,0 +1,334 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "agg_command.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "aggregate.h"
+
+namespace {
+
+using sw::redis::pb::Error;
+
+template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+void reply_with_result(RedisModuleCtx *ctx, T val) {
+    RedisModule_ReplyWithLongLong(ctx, val);
+}
+
+// Reply floating-point results with 17 significant digits, so that they can be
+// parsed back to the same double. std::to_string only keeps 6 decimal places.
+void reply_with_result(RedisModuleCtx *ctx, double val) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.17g", val);
+
+    RedisModule_ReplyWithSimpleString(ctx, buf);
+}
+
+// Integer kernels. Compilers can vectorize these loops by themselves, and we
+// vectorize floating-point kernels explicitly, see aggregate.h for detail.
+
+template <typename T, typename std::enable_if<std::is_signed<T>::value, int>::type = 0>
+int64_t sum(const T *data, std::size_t size) {
+    int64_t acc = 0;
+    for (std::size_t idx = 0; idx != size; ++idx) {
+        if (__builtin_add_overflow(acc, static_cast<int64_t>(data[idx]), &acc)) {
+            throw Error("overflow");
+        }
+    }
+
+    return acc;
+}
+
+template <typename T, typename std::enable_if<std::is_unsigned<T>::value, int>::type = 0>
+uint64_t sum(const T *data, std::size_t size) {
+    uint64_t acc = 0;
+    for (std::size_t idx = 0; idx != size; ++idx) {
+        if (__builtin_add_overflow(acc, static_cast<uint64_t>(data[idx]), &acc)) {
+            throw Error("overflow");
+        }
+    }
+
+    return acc;
+}
+
+template <typename T>
+T min(const T *data, std::size_t size) {
+    return *std::min_element(data, data + size);
+}
+
+template <typename T>
+T max(const T *data, std::size_t size) {
+    return *std::max_element(data, data + size);
+}
+
+template <typename T>
+double avg(const T *data, std::size_t size) {
+    // Avoid overflow without checking each addition.
+    long double acc = 0;
+    for (std::size_t idx = 0; idx != size; ++idx) {
+        acc += data[idx];
+    }
+
+    return static_cast<double>(acc / size);
+}
+
+double sum(const double *data, std::size_t size) {
+    return sw::redis::pb::aggregate::sum(data, size);
+}
+
+double sum(const float *data, std::size_t size) {
+    return sw::redis::pb::aggregate::sum(data, size);
+}
+
+double min(const double *data, std::size_t size) {
+    return sw::redis::pb::aggregate::min(data, size);
+}
+
+float min(const float *data, std::size_t size) {
+    return sw::redis::pb::aggregate::min(data, size);
+}
+
+double max(const double *data, std::size_t size) {
+    return sw::redis::pb::aggregate::max(data, size);
+}
+
+float max(const float *data, std::size_t size) {
+    return sw::redis::pb::aggregate::max(data, size);
+}
+
+double avg(const double *data, std::size_t size) {
+    return sum(data, size) / size;
+}
+
+double avg(const float *data, std::size_t size) {
+    return sum(data, size) / size;
+}
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int AggCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto key = api::open_key(ctx, args.key_name, api::KeyMode::READONLY);
+        if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
+            return RedisModule_ReplyWithNull(ctx);
+        }
+
+        auto *msg = api::get_msg_by_key(key.get());
+        assert(msg != nullptr);
+
+        _aggregate(ctx, *msg, args);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+AggCommand::Args AggCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 5 && argc != 6) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.key_name = argv[1];
+    args.path = Path(argv[2], argv[3]);
+    args.op = _parse_op(argv[4]);
+
+    if (args.op == Args::Op::PERCENTILE) {
+        if (argc != 6) {
+            throw WrongArityError();
+        }
+
+        try {
+            args.percentile = util::sv_to_double(argv[5]);
+        } catch (const Error &) {
+            throw Error("invalid percentile");
+        }
+
+        if (!(args.percentile >= 0 && args.percentile <= 100)) {
+            throw Error("percentile should be in [0, 100]");
+        }
+    } else if (argc != 5) {
+        throw WrongArityError();
+    }
+
+    return args;
+}
+
+auto AggCommand::_parse_op(const StringView &op) const -> Args::Op {
+    if (util::str_case_equal(op, "SUM")) {
+        return Args::Op::SUM;
+    } else if (util::str_case_equal(op, "MIN")) {
+        return Args::Op::MIN;
+    } else if (util::str_case_equal(op, "MAX")) {
+        return Args::Op::MAX;
+    } else if (util::str_case_equal(op, "AVG")) {
+        return Args::Op::AVG;
+    } else if (util::str_case_equal(op, "COUNT")) {
+        return Args::Op::COUNT;
+    } else if (util::str_case_equal(op, "PERCENTILE")) {
+        return Args::Op::PERCENTILE;
+    }
+
+    throw Error("unknown aggregation: " + util::sv_to_string(op));
+}
+
+void AggCommand::_aggregate(RedisModuleCtx *ctx, const gp::Message &msg, const Args &args) const {
+    if (msg.GetTypeName() != args.path.type()) {
+        throw Error("type mismatch");
+    }
+
+    ConstFieldRef field(&msg, args.path);
+    if (field.missing()) {
+        throw Error(field.missing_reason());
+    }
+
+    if (!field.is_array() || field.is_map() || field.is_array_element() || field.is_array_slice()) {
+        throw Error("not an array");
+    }
+
+    if (args.op == Args::Op::COUNT) {
+        RedisModule_ReplyWithLongLong(ctx, field.size());
+        return;
+    }
+
+    switch (field.type()) {
+    case gp::FieldDescriptor::CPPTYPE_INT32:
+        _aggregate(ctx, field.repeated_field<int32_t>(), args);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_INT64:
+        _aggregate(ctx, field.repeated_field<int64_t>(), args);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_UINT32:
+        _aggregate(ctx, field.repeated_field<uint32_t>(), args);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_UINT64:
+        _aggregate(ctx, field.repeated_field<uint64_t>(), args);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
+        _aggregate(ctx, field.repeated_field<double>(), args);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_FLOAT:
+        _aggregate(ctx, field.repeated_field<float>(), args);
+        break;
+
+    default:
+        throw Error("not a numeric array");
+    }
+}
+
+template <typename T>
+void AggCommand::_aggregate(RedisModuleCtx *ctx,
+        const gp::RepeatedField<T> &arr,
+        const Args &args) const {
+    const auto *data = arr.data();
+    std::size_t size = arr.size();
+
+    if (size == 0) {
+        if (args.op == Args::Op::SUM) {
+            RedisModule_ReplyWithLongLong(ctx, 0);
+        } else {
+            RedisModule_ReplyWithNull(ctx);
+        }
+
+        return;
+    }
+
+    switch (args.op) {
+    case Args::Op::SUM:
+        reply_with_result(ctx, sum(data, size));
+        break;
+
+    case Args::Op::MIN:
+        reply_with_result(ctx, min(data, size));
+        break;
+
+    case Args::Op::MAX:
+        reply_with_result(ctx, max(data, size));
+        break;
+
+    case Args::Op::AVG:
+        reply_with_result(ctx, avg(data, size));
+        break;
+
+    case Args::Op::PERCENTILE:
+        _percentile(ctx, arr, args.percentile);
+        break;
+
+    default:
+        assert(false);
+    }
+}
+
+template <typename T>
+void AggCommand::_percentile(RedisModuleCtx *ctx,
+        const gp::RepeatedField<T> &arr,
+        double p) const {
+    // NaN cannot be ordered, and it propagates in the same way as MIN and MAX.
+    if (std::any_of(arr.begin(), arr.end(), [](T val) { return std::isnan(val); })) {
+        reply_with_result(ctx, std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+
+    // Partial sort a copy, since the array cannot be reordered.
+    std::vector<T> vals(arr.begin(), arr.end());
+
+    auto rank = p / 100 * (vals.size() - 1);
+    auto lower = static_cast<std::size_t>(std::floor(rank));
+
+    std::nth_element(vals.begin(), vals.begin() + lower, vals.end());
+    double result = vals[lower];
+    if (lower + 1 < vals.size() && rank > lower) {
+        // The next rank is the minimum of the elements after the lower one.
+        double upper = *std::min_element(vals.begin() + lower + 1, vals.end());
+        result += (upper - result) * (rank - lower);
+    }
+
+    reply_with_result(ctx, result);
+}
+
+}
+
+}
+
+}
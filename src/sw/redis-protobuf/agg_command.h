@@ -0,0 +1,86 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_AGG_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_AGG_COMMANDS_H
+
+#include "module_api.h"
+#include "utils.h"
+#include "field_ref.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.AGG key type path SUM|MIN|MAX|AVG|COUNT|PERCENTILE p
+// return:  COUNT: Integer reply: the number of elements of the array.
+//          SUM, MIN, MAX: Integer reply for integer arrays, and simple string
+//          reply of the number for floating-point arrays.
+//          AVG, PERCENTILE: Simple string reply of the number. p is in [0, 100],
+//          and the result is linearly interpolated between the closest ranks.
+//          If the key doesn't exist, return a nil reply. If the array is empty,
+//          return 0 for COUNT and SUM, and a nil reply for others.
+// error:   If the path doesn't exist, or the corresponding field is not an array,
+//          or not a numeric array (except COUNT), or sum of integers overflows,
+//          or type mismatch, return an error reply.
+class AggCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        RedisModuleString *key_name;
+
+        Path path;
+
+        enum class Op {
+            SUM = 0,
+            MIN,
+            MAX,
+            AVG,
+            COUNT,
+            PERCENTILE
+        };
+
+        Op op;
+
+        // Only for PERCENTILE.
+        double percentile = 0;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    Args::Op _parse_op(const StringView &op) const;
+
+    void _aggregate(RedisModuleCtx *ctx, const gp::Message &msg, const Args &args) const;
+
+    // Aggregate elements in place, without copying them out of the RepeatedField.
+    template <typename T>
+    void _aggregate(RedisModuleCtx *ctx, const gp::RepeatedField<T> &arr, const Args &args) const;
+
+    template <typename T>
+    void _percentile(RedisModuleCtx *ctx, const gp::RepeatedField<T> &arr, double p) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_AGG_COMMANDS_H
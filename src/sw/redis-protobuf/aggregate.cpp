@@ -0,0 +1,415 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "aggregate.h"
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define SEWENEW_REDISPROTOBUF_X86_SIMD
+
+#include <immintrin.h>
+
+#endif
+
+namespace {
+
+// Scalar kernels, which are also used for the tails of vectorized kernels.
+
+template <typename T>
+double scalar_sum(const T *data, std::size_t size, double init) {
+    for (std::size_t idx = 0; idx != size; ++idx) {
+        init += data[idx];
+    }
+
+    return init;
+}
+
+template <typename T>
+T scalar_min(const T *data, std::size_t size, T init) {
+    for (std::size_t idx = 0; idx != size; ++idx) {
+        if (std::isnan(data[idx])) {
+            return std::numeric_limits<T>::quiet_NaN();
+        }
+
+        init = data[idx] < init ? data[idx] : init;
+    }
+
+    return init;
+}
+
+template <typename T>
+T scalar_max(const T *data, std::size_t size, T init) {
+    for (std::size_t idx = 0; idx != size; ++idx) {
+        if (std::isnan(data[idx])) {
+            return std::numeric_limits<T>::quiet_NaN();
+        }
+
+        init = data[idx] > init ? data[idx] : init;
+    }
+
+    return init;
+}
+
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+
+bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+
+    return supported;
+}
+
+bool has_sse2() {
+    static const bool supported = __builtin_cpu_supports("sse2");
+
+    return supported;
+}
+
+__attribute__((target("avx2")))
+double avx2_sum(const double *data, std::size_t size) {
+    // Two accumulators to hide the latency of additions.
+    auto acc0 = _mm256_setzero_pd();
+    auto acc1 = _mm256_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + idx));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + idx + 4));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+
+    return scalar_sum(data + idx, size - idx, lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+__attribute__((target("avx2")))
+double avx2_sum(const float *data, std::size_t size) {
+    auto acc0 = _mm256_setzero_pd();
+    auto acc1 = _mm256_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm_loadu_ps(data + idx)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm_loadu_ps(data + idx + 4)));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+
+    return scalar_sum(data + idx, size - idx, lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+__attribute__((target("avx2")))
+double avx2_min(const double *data, std::size_t size) {
+    auto acc = _mm256_set1_pd(data[0]);
+    auto nan = _mm256_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+        auto val = _mm256_loadu_pd(data + idx);
+        acc = _mm256_min_pd(val, acc);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(val, val, _CMP_UNORD_Q));
+    }
+
+    if (_mm256_movemask_pd(nan) != 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+
+    return scalar_min(data + idx, size - idx, scalar_min(lanes, 4, lanes[0]));
+}
+
+__attribute__((target("avx2")))
+float avx2_min(const float *data, std::size_t size) {
+    auto acc = _mm256_set1_ps(data[0]);
+    auto nan = _mm256_setzero_ps();
+    std::size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        auto val = _mm256_loadu_ps(data + idx);
+        acc = _mm256_min_ps(val, acc);
+        nan = _mm256_or_ps(nan, _mm256_cmp_ps(val, val, _CMP_UNORD_Q));
+    }
+
+    if (_mm256_movemask_ps(nan) != 0) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+
+    return scalar_min(data + idx, size - idx, scalar_min(lanes, 8, lanes[0]));
+}
+
+__attribute__((target("avx2")))
+double avx2_max(const double *data, std::size_t size) {
+    auto acc = _mm256_set1_pd(data[0]);
+    auto nan = _mm256_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+        auto val = _mm256_loadu_pd(data + idx);
+        acc = _mm256_max_pd(val, acc);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(val, val, _CMP_UNORD_Q));
+    }
+
+    if (_mm256_movemask_pd(nan) != 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+
+    return scalar_max(data + idx, size - idx, scalar_max(lanes, 4, lanes[0]));
+}
+
+__attribute__((target("avx2")))
+float avx2_max(const float *data, std::size_t size) {
+    auto acc = _mm256_set1_ps(data[0]);
+    auto nan = _mm256_setzero_ps();
+    std::size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        auto val = _mm256_loadu_ps(data + idx);
+        acc = _mm256_max_ps(val, acc);
+        nan = _mm256_or_ps(nan, _mm256_cmp_ps(val, val, _CMP_UNORD_Q));
+    }
+
+    if (_mm256_movemask_ps(nan) != 0) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+
+    return scalar_max(data + idx, size - idx, scalar_max(lanes, 8, lanes[0]));
+}
+
+__attribute__((target("sse2")))
+double sse2_sum(const double *data, std::size_t size) {
+    auto acc0 = _mm_setzero_pd();
+    auto acc1 = _mm_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + idx));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + idx + 2));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+
+    return scalar_sum(data + idx, size - idx, lanes[0] + lanes[1]);
+}
+
+__attribute__((target("sse2")))
+double sse2_sum(const float *data, std::size_t size) {
+    auto acc0 = _mm_setzero_pd();
+    auto acc1 = _mm_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+        auto vals = _mm_loadu_ps(data + idx);
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(vals));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(vals, vals)));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+
+    return scalar_sum(data + idx, size - idx, lanes[0] + lanes[1]);
+}
+
+__attribute__((target("sse2")))
+double sse2_min(const double *data, std::size_t size) {
+    auto acc = _mm_set1_pd(data[0]);
+    auto nan = _mm_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 2 <= size; idx += 2) {
+        auto val = _mm_loadu_pd(data + idx);
+        acc = _mm_min_pd(val, acc);
+        nan = _mm_or_pd(nan, _mm_cmpunord_pd(val, val));
+    }
+
+    if (_mm_movemask_pd(nan) != 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+
+    return scalar_min(data + idx, size - idx, scalar_min(lanes, 2, lanes[0]));
+}
+
+__attribute__((target("sse2")))
+float sse2_min(const float *data, std::size_t size) {
+    auto acc = _mm_set1_ps(data[0]);
+    auto nan = _mm_setzero_ps();
+    std::size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+        auto val = _mm_loadu_ps(data + idx);
+        acc = _mm_min_ps(val, acc);
+        nan = _mm_or_ps(nan, _mm_cmpunord_ps(val, val));
+    }
+
+    if (_mm_movemask_ps(nan) != 0) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+
+    return scalar_min(data + idx, size - idx, scalar_min(lanes, 4, lanes[0]));
+}
+
+__attribute__((target("sse2")))
+double sse2_max(const double *data, std::size_t size) {
+    auto acc = _mm_set1_pd(data[0]);
+    auto nan = _mm_setzero_pd();
+    std::size_t idx = 0;
+    for (; idx + 2 <= size; idx += 2) {
+        auto val = _mm_loadu_pd(data + idx);
+        acc = _mm_max_pd(val, acc);
+        nan = _mm_or_pd(nan, _mm_cmpunord_pd(val, val));
+    }
+
+    if (_mm_movemask_pd(nan) != 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+
+    return scalar_max(data + idx, size - idx, scalar_max(lanes, 2, lanes[0]));
+}
+
+__attribute__((target("sse2")))
+float sse2_max(const float *data, std::size_t size) {
+    auto acc = _mm_set1_ps(data[0]);
+    auto nan = _mm_setzero_ps();
+    std::size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+        auto val = _mm_loadu_ps(data + idx);
+        acc = _mm_max_ps(val, acc);
+        nan = _mm_or_ps(nan, _mm_cmpunord_ps(val, val));
+    }
+
+    if (_mm_movemask_ps(nan) != 0) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+
+    return scalar_max(data + idx, size - idx, scalar_max(lanes, 4, lanes[0]));
+}
+
+#endif
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace aggregate {
+
+double sum(const double *data, std::size_t size) {
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+    if (has_avx2()) {
+        return avx2_sum(data, size);
+    } else if (has_sse2()) {
+        return sse2_sum(data, size);
+    }
+#endif
+
+    return scalar_sum(data, size, 0.0);
+}
+
+double sum(const float *data, std::size_t size) {
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+    if (has_avx2()) {
+        return avx2_sum(data, size);
+    } else if (has_sse2()) {
+        return sse2_sum(data, size);
+    }
+#endif
+
+    return scalar_sum(data, size, 0.0);
+}
+
+double min(const double *data, std::size_t size) {
+    assert(size > 0);
+
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+    if (has_avx2()) {
+        return avx2_min(data, size);
+    } else if (has_sse2()) {
+        return sse2_min(data, size);
+    }
+#endif
+
+    return scalar_min(data, size, data[0]);
+}
+
+float min(const float *data, std::size_t size) {
+    assert(size > 0);
+
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+    if (has_avx2()) {
+        return avx2_min(data, size);
+    } else if (has_sse2()) {
+        return sse2_min(data, size);
+    }
+#endif
+
+    return scalar_min(data, size, data[0]);
+}
+
+double max(const double *data, std::size_t size) {
+    assert(size > 0);
+
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+    if (has_avx2()) {
+        return avx2_max(data, size);
+    } else if (has_sse2()) {
+        return sse2_max(data, size);
+    }
+#endif
+
+    return scalar_max(data, size, data[0]);
+}
+
+float max(const float *data, std::size_t size) {
+    assert(size > 0);
+
+#ifdef SEWENEW_REDISPROTOBUF_X86_SIMD
+    if (has_avx2()) {
+        return avx2_max(data, size);
+    } else if (has_sse2()) {
+        return sse2_max(data, size);
+    }
+#endif
+
+    return scalar_max(data, size, data[0]);
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,54 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_AGGREGATE_H
+#define SEWENEW_REDISPROTOBUF_AGGREGATE_H
+
+#include <cstddef>
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Aggregation kernels over contiguous floating-point arrays, e.g. the underlying
+// storage of RepeatedField<double>. They're vectorized with AVX2 or SSE2, if the
+// CPU supports, and fall back to scalar loops otherwise. Since the vectorized
+// kernels add elements in a different order, sums might differ from a sequential
+// loop in the last bits. NaN propagates, i.e. if the array has NaN, min and max return NaN.
+namespace aggregate {
+
+// Floats are summed as doubles to reduce rounding errors.
+double sum(const double *data, std::size_t size);
+double sum(const float *data, std::size_t size);
+
+// The following functions require size > 0.
+double min(const double *data, std::size_t size);
+float min(const float *data, std::size_t size);
+
+double max(const double *data, std::size_t size);
+float max(const float *data, std::size_t size);
+
+}
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_AGGREGATE_H
@@ -15,57 +15,223 @@
  *************************************************************************/
 
 #include "append_command.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <google/protobuf/io/coded_stream.h>
 #include "errors.h"
 #include "redis_protobuf.h"
+#include "field_type.h"
+
+namespace {
+
+using sw::redis::pb::gp::FieldDescriptor;
+using sw::redis::pb::gp::RepeatedField;
+using sw::redis::pb::gp::io::CodedInputStream;
+using sw::redis::pb::Error;
+using sw::redis::pb::FieldType;
+using sw::redis::pb::MutableFieldRef;
+using sw::redis::pb::StringView;
+
+template <FieldDescriptor::CppType T>
+struct AddHandler {
+    using Type = typename FieldType<T>::Type;
+
+    static void run(MutableFieldRef &field, const std::vector<StringView> &elements) {
+        // Convert all elements before modifying the array, so that if any
+        // element is invalid, nothing is appended.
+        std::vector<Type> vals;
+        vals.reserve(elements.size());
+        for (const auto &ele : elements) {
+            vals.push_back(FieldType<T>::parse(field, ele));
+        }
 
-namespace sw {
+        // Reserve the final size once, instead of growing the array step by step.
+        _reserve(field, field.size() + static_cast<int>(vals.size()));
 
-namespace redis {
+        for (const auto &val : vals) {
+            FieldType<T>::add(field, val);
+        }
+    }
 
-namespace pb {
+    static void _reserve(MutableFieldRef &field, int size) {
+        _reserve(field, size, std::integral_constant<bool,
+                T == FieldDescriptor::CPPTYPE_STRING || T == FieldDescriptor::CPPTYPE_MESSAGE>());
+    }
 
-int AppendCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
-    try {
-        assert(ctx != nullptr);
+    static void _reserve(MutableFieldRef &field, int size, std::false_type) {
+        field.mutable_repeated_field<Type>().Reserve(size);
+    }
 
-        auto args = _parse_args(argv, argc);
-        const auto &path = args.path;
-        if (path.empty()) {
-            throw Error("can only call append on array");
+    static void _reserve(MutableFieldRef &field, int size, std::true_type) {
+        using PtrType = typename std::conditional<T == FieldDescriptor::CPPTYPE_STRING,
+                std::string, sw::redis::pb::gp::Message>::type;
+
+        field.mutable_repeated_ptr_field<PtrType>().Reserve(size);
+    }
+};
+
+uint64_t zigzag_decode(uint64_t val) {
+    return (val >> 1) ^ (~(val & 1) + 1);
+}
+
+uint32_t zigzag_decode(uint32_t val) {
+    return (val >> 1) ^ (~(val & 1) + 1);
+}
+
+// Decode fixed width little-endian values, i.e. RAW format, or fixed32, fixed64,
+// sfixed32, sfixed64, float and double in protobuf packed format.
+template <typename T>
+void decode_fixed(const uint8_t *buf, std::size_t num, T *out, std::integral_constant<int, 4>) {
+    for (std::size_t idx = 0; idx != num; ++idx) {
+        uint32_t val = 0;
+        buf = CodedInputStream::ReadLittleEndian32FromArray(buf, &val);
+        std::memcpy(out + idx, &val, sizeof(val));
+    }
+}
+
+template <typename T>
+void decode_fixed(const uint8_t *buf, std::size_t num, T *out, std::integral_constant<int, 8>) {
+    for (std::size_t idx = 0; idx != num; ++idx) {
+        uint64_t val = 0;
+        buf = CodedInputStream::ReadLittleEndian64FromArray(buf, &val);
+        std::memcpy(out + idx, &val, sizeof(val));
+    }
+}
+
+template <typename T>
+void decode_fixed(const uint8_t *buf, std::size_t num, T *out, std::integral_constant<int, 1>) {
+    // Only bool is 1 byte.
+    for (std::size_t idx = 0; idx != num; ++idx) {
+        out[idx] = (buf[idx] != 0);
+    }
+}
+
+template <typename T>
+void append_fixed(RepeatedField<T> &arr, const StringView &blob) {
+    if (blob.size() % sizeof(T) != 0) {
+        throw Error("invalid packed blob: size is not a multiple of "
+                + std::to_string(sizeof(T)));
+    }
+
+    auto num = blob.size() / sizeof(T);
+    auto old_size = arr.size();
+
+    // Resize once, and decode in place.
+    arr.Resize(old_size + static_cast<int>(num), T());
+
+    decode_fixed(reinterpret_cast<const uint8_t *>(blob.data()),
+            num,
+            arr.mutable_data() + old_size,
+            std::integral_constant<int, sizeof(T)>());
+}
+
+template <typename T>
+void append_varint(RepeatedField<T> &arr,
+        const StringView &blob,
+        FieldDescriptor::Type type) {
+    const auto *buf = reinterpret_cast<const uint8_t *>(blob.data());
+
+    // Each varint ends with a byte without the continuation bit, so that we can
+    // reserve the exact capacity before decoding.
+    auto num = std::count_if(buf, buf + blob.size(), [](uint8_t b) { return (b & 0x80) == 0; });
+
+    auto old_size = arr.size();
+    arr.Reserve(old_size + static_cast<int>(num));
+
+    CodedInputStream input(buf, static_cast<int>(blob.size()));
+    while (input.CurrentPosition() != static_cast<int>(blob.size())) {
+        uint64_t val = 0;
+        if (!input.ReadVarint64(&val)) {
+            // Roll back, so that nothing is appended.
+            arr.Truncate(old_size);
+            throw Error("invalid packed blob: bad varint");
         }
 
-        auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
-        assert(key);
+        switch (type) {
+        case FieldDescriptor::TYPE_SINT32:
+            arr.Add(static_cast<T>(static_cast<int32_t>(
+                            zigzag_decode(static_cast<uint32_t>(val)))));
+            break;
+
+        case FieldDescriptor::TYPE_SINT64:
+            arr.Add(static_cast<T>(static_cast<int64_t>(zigzag_decode(val))));
+            break;
+
+        default:
+            arr.Add(static_cast<T>(val));
+            break;
+        }
+    }
+}
 
-        auto &m = RedisProtobuf::instance();
+template <typename T>
+void append_proto(RepeatedField<T> &arr,
+        const StringView &blob,
+        FieldDescriptor::Type type) {
+    switch (type) {
+    case FieldDescriptor::TYPE_FIXED32:
+    case FieldDescriptor::TYPE_SFIXED32:
+    case FieldDescriptor::TYPE_FIXED64:
+    case FieldDescriptor::TYPE_SFIXED64:
+    case FieldDescriptor::TYPE_FLOAT:
+    case FieldDescriptor::TYPE_DOUBLE:
+        // Fixed width types are encoded as little-endian values of the C++ type.
+        append_fixed(arr, blob);
+        break;
 
-        long long len = 0;
-        if (!api::key_exists(key.get(), m.type())) {
-            auto msg = m.proto_factory()->create(path.type());
+    default:
+        append_varint(arr, blob, type);
+        break;
+    }
+}
 
-            assert(msg != nullptr);
-            if (msg->GetTypeName() != path.type()) {
-                throw Error("type mismatch");
-            }
+template <FieldDescriptor::CppType T>
+using IsNumeric = std::integral_constant<bool,
+      T != FieldDescriptor::CPPTYPE_STRING && T != FieldDescriptor::CPPTYPE_MESSAGE>;
 
-            MutableFieldRef field(msg.get(), path);
-            len = _append(field, args.elements);
+template <FieldDescriptor::CppType T>
+struct PackedHandler {
+    using Type = typename FieldType<T>::Type;
 
-            if (RedisModule_ModuleTypeSetValue(key.get(),
-                        m.type(),
-                        msg.get()) != REDISMODULE_OK) {
-                throw Error("failed to set message");
-            }
+    static void run(MutableFieldRef &field, const StringView &blob, bool raw) {
+        _append(field, blob, raw, IsNumeric<T>());
+    }
 
-            msg.release();
+    static void _append(MutableFieldRef &field,
+            const StringView &blob,
+            bool raw,
+            std::true_type) {
+        auto &arr = field.mutable_repeated_field<Type>();
+        if (raw) {
+            append_fixed(arr, blob);
         } else {
-            auto *msg = api::get_msg_by_key(key.get());
-            assert(msg != nullptr);
-
-            MutableFieldRef field(msg, path);
-            // TODO: create a new message, and append to that message, then swap to this message.
-            len = _append(field, args.elements);
+            append_proto(arr, blob, field.declared_type());
         }
+    }
+
+    static void _append(MutableFieldRef &, const StringView &, bool, std::false_type) {
+        throw Error("not a numeric array");
+    }
+};
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int AppendCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto len = _run(ctx, args);
 
         RedisModule_ReplyWithLongLong(ctx, len);
 
@@ -81,6 +247,50 @@ int AppendCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     return REDISMODULE_ERR;
 }
 
+long long AppendCommand::_run(RedisModuleCtx *ctx, const Args &args) const {
+    assert(ctx != nullptr);
+
+    const auto &path = args.path;
+    if (path.empty()) {
+        throw Error("can only call append on array");
+    }
+
+    auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
+    assert(key);
+
+    auto &m = RedisProtobuf::instance();
+
+    long long len = 0;
+    if (!api::key_exists(key.get(), m.type())) {
+        auto msg = m.proto_factory()->create(path.type());
+
+        assert(msg != nullptr);
+        if (msg->GetTypeName() != path.type()) {
+            throw Error("type mismatch");
+        }
+
+        MutableFieldRef field(msg.get(), path);
+        len = _append_field(field, args);
+
+        if (RedisModule_ModuleTypeSetValue(key.get(),
+                    m.type(),
+                    msg.get()) != REDISMODULE_OK) {
+            throw Error("failed to set message");
+        }
+
+        msg.release();
+    } else {
+        auto *msg = api::get_msg_by_key(key.get());
+        assert(msg != nullptr);
+
+        MutableFieldRef field(msg, path);
+        // All elements are converted before modifying the message, so that it's all-or-nothing.
+        len = _append_field(field, args);
+    }
+
+    return len;
+}
+
 AppendCommand::Args AppendCommand::_parse_args(RedisModuleString **argv, int argc) const {
     assert(argv != nullptr);
 
@@ -90,80 +300,152 @@ AppendCommand::Args AppendCommand::_parse_args(RedisModuleString **argv, int arg
 
     Args args;
     args.key_name = argv[1];
-    args.path = Path(argv[2], argv[3]);
-    args.elements.reserve(argc - 4);
 
-    for (auto idx = 4; idx != argc; ++idx) {
+    auto pos = _parse_opts(argv, argc, args);
+    if (pos + 3 > argc) {
+        throw WrongArityError();
+    }
+
+    args.path = Path(argv[pos], argv[pos + 1]);
+    pos += 2;
+
+    if (args.packed != Args::Packed::NONE && pos + 1 != argc) {
+        throw Error("only one blob can be specified with --PACKED");
+    }
+
+    args.elements.reserve(argc - pos);
+
+    for (auto idx = pos; idx != argc; ++idx) {
         args.elements.emplace_back(argv[idx]);
     }
 
     return args;
 }
 
-long long AppendCommand::_append(MutableFieldRef &field,
-        const std::vector<StringView> &elements) const {
-    if (field.is_array() && !field.is_array_element()) {
-        for (const auto &ele : elements) {
-            _append_arr(field, ele);
+int AppendCommand::_parse_opts(RedisModuleString **argv, int argc, Args &args) const {
+    auto idx = 2;
+    while (idx < argc) {
+        auto opt = StringView(argv[idx]);
+        if (util::str_case_equal(opt, "--PACKED")) {
+            if (idx + 1 >= argc) {
+                throw Error("syntax error");
+            }
+
+            ++idx;
+
+            args.packed = _parse_packed(argv[idx]);
+        } else if (util::str_case_equal(opt, "--MAXLEN")) {
+            if (idx + 1 >= argc) {
+                throw Error("syntax error");
+            }
+
+            ++idx;
+
+            args.maxlen = util::sv_to_int64(argv[idx]);
+            if (args.maxlen < 0) {
+                throw Error("--MAXLEN should be non-negative");
+            }
+
+            if (idx + 1 < argc && util::str_case_equal(StringView(argv[idx + 1]), "~")) {
+                ++idx;
+                args.approx = true;
+            }
+        } else {
+            // Finish parsing options.
+            break;
         }
 
-        return field.size();
-    } else if (field.type() == gp::FieldDescriptor::CPPTYPE_STRING) {
-        return _append_str(field, elements);
-    } else {
-        throw Error("not an array or string");
+        ++idx;
     }
+
+    return idx;
 }
 
-void AppendCommand::_append_arr(MutableFieldRef &field, const StringView &val) const {
-    assert(field.is_array() && !field.is_array_element());
+AppendCommand::Args::Packed AppendCommand::_parse_packed(const StringView &packed) const {
+    if (util::str_case_equal(packed, "RAW")) {
+        return Args::Packed::RAW;
+    } else if (util::str_case_equal(packed, "PROTO")) {
+        return Args::Packed::PROTO;
+    } else {
+        throw Error("invalid packed format: " + std::string(packed.data(), packed.size()));
+    }
+}
 
-    switch (field.type()) {
-    case gp::FieldDescriptor::CPPTYPE_INT32:
-        field.add_int32(util::sv_to_int32(val));
-        break;
+long long AppendCommand::_append_field(MutableFieldRef &field, const Args &args) const {
+    auto is_arr = field.is_array() && !field.is_array_element() && !field.is_map()
+        && !field.is_array_slice();
+    if (args.maxlen >= 0 && !is_arr) {
+        throw Error("--MAXLEN only works with array");
+    }
 
-    case gp::FieldDescriptor::CPPTYPE_INT64:
-        field.add_int64(util::sv_to_int64(val));
-        break;
+    long long len = 0;
+    if (args.packed == Args::Packed::NONE) {
+        len = _append(field, args.elements);
+    } else {
+        len = _append_packed(field, args.elements.front(), args.packed);
+    }
 
-    case gp::FieldDescriptor::CPPTYPE_UINT32:
-        field.add_uint32(util::sv_to_uint32(val));
-        break;
+    if (args.maxlen >= 0) {
+        len = _trim(field, args.maxlen, args.approx);
+    }
 
-    case gp::FieldDescriptor::CPPTYPE_UINT64:
-        field.add_uint64(util::sv_to_uint64(val));
-        break;
+    return len;
+}
 
-    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
-        field.add_double(util::sv_to_double(val));
-        break;
+long long AppendCommand::_trim(MutableFieldRef &field, long long maxlen, bool approx) const {
+    long long size = field.size();
+    if (size <= maxlen) {
+        return size;
+    }
 
-    case gp::FieldDescriptor::CPPTYPE_FLOAT:
-        field.add_float(util::sv_to_float(val));
-        break;
+    if (approx) {
+        // Only trim when the array exceeds the limit by a quarter of it, so that the
+        // cost of moving the remaining elements is amortized over the appended ones.
+        auto slack = std::max(maxlen / 4, 1LL);
+        if (size - maxlen < slack) {
+            return size;
+        }
+    }
 
-    case gp::FieldDescriptor::CPPTYPE_BOOL:
-        field.add_bool(util::sv_to_bool(val));
-        break;
+    // Drop the oldest elements, i.e. those at the head of the array.
+    field.del_range(0, static_cast<int>(size - maxlen));
 
-    case gp::FieldDescriptor::CPPTYPE_ENUM:
-        field.add_enum(util::sv_to_int32(val));
-        break;
+    return maxlen;
+}
 
-    case gp::FieldDescriptor::CPPTYPE_STRING:
-        field.add_string(util::sv_to_string(val));
-        break;
+long long AppendCommand::_append(MutableFieldRef &field,
+        const std::vector<StringView> &elements) const {
+    if (field.is_map_element()) {
+        if (field.map_value_type() != gp::FieldDescriptor::CPPTYPE_STRING) {
+            throw Error("not a string");
+        }
 
-    case gp::FieldDescriptor::CPPTYPE_MESSAGE:
-        _add_msg(field, val);
-        break;
+        return _append_str(field, elements);
+    } else if (field.is_map()) {
+        throw Error("cannot append to a map");
+    } else if (field.is_array_slice()) {
+        throw Error("cannot append to an array slice");
+    } else if (field.is_array() && !field.is_array_element()) {
+        _append_arr(field, elements);
 
-    default:
-        throw Error("unknown type");
+        return field.size();
+    } else if (field.type() == gp::FieldDescriptor::CPPTYPE_STRING) {
+        return _append_str(field, elements);
+    } else {
+        throw Error("not an array or string");
     }
 }
 
+void AppendCommand::_append_arr(MutableFieldRef &field,
+        const std::vector<StringView> &elements) const {
+    assert(field.is_array() && !field.is_array_element());
+
+    static const TypeDispatchTable<AddHandler,
+            void (*)(MutableFieldRef &, const std::vector<StringView> &)> table;
+
+    table[field.type()](field, elements);
+}
+
 long long AppendCommand::_append_str(MutableFieldRef &field,
         const std::vector<StringView> &elements) const {
     std::string str;
@@ -171,11 +453,13 @@ long long AppendCommand::_append_str(MutableFieldRef &field,
         str += std::string(ele.data(), ele.size());
     }
 
-    if (field.is_array_element()) {
+    if (field.is_map_element()) {
+        // Append in place, and if the key doesn't exist, it's inserted.
+        return field.append_mapped_string(str);
+    } else if (field.is_array_element()) {
         str = field.get_repeated_string() + str;
         field.set_repeated_string(str);
     } else {
-        // TODO: map element
         str = field.get_string() + str;
         field.set_string(str);
     }
@@ -183,11 +467,20 @@ long long AppendCommand::_append_str(MutableFieldRef &field,
     return str.size();
 }
 
-void AppendCommand::_add_msg(MutableFieldRef &field, const StringView &val) const {
-    auto msg = RedisProtobuf::instance().proto_factory()->create(field.msg_type(), val);
-    assert(msg);
+long long AppendCommand::_append_packed(MutableFieldRef &field,
+        const StringView &blob,
+        Args::Packed packed) const {
+    if (!field.is_array() || field.is_array_element() || field.is_map()
+            || field.is_array_slice()) {
+        throw Error("not an array");
+    }
+
+    static const TypeDispatchTable<PackedHandler,
+            void (*)(MutableFieldRef &, const StringView &, bool)> table;
+
+    table[field.type()](field, blob, packed == Args::Packed::RAW);
 
-    field.add_msg(*msg);
+    return field.size();
 }
 
 }
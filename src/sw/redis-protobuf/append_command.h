@@ -29,31 +29,69 @@ namespace redis {
 
 namespace pb {
 
-// command: PB.APPEND key type path element [element, element...]
+// command: PB.APPEND key [--PACKED RAW|PROTO] [--MAXLEN n [~]] type path element [element ...]
 // return:  Integer reply: return the length of the array after the append operations.
 //          Or return the length of the string after the append operations.
 // error:   If the path doesn't exist, or the corresponding field is not an array, or
 //          a string, return an error reply.
+// options: --PACKED: Append a single blob of numeric elements to a numeric array.
+//          RAW means fixed width little-endian values of the field's C++ type,
+//          e.g. 4 bytes for int32, sint32, fixed32 and enum, and 1 byte for bool.
+//          PROTO means the payload of a packed repeated field in protobuf wire format.
+//          --MAXLEN: Cap the array, i.e. drop the oldest elements from the head, so that
+//          the array has at most n elements. With ~, the array is trimmed only when it
+//          exceeds n by a quarter of n, so that trimming is amortized O(1) per element.
 class AppendCommand {
 public:
     int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
 
 private:
     struct Args {
+        enum class Packed {
+            NONE = 0,
+            RAW,
+            PROTO
+        };
+
         RedisModuleString *key_name;
         Path path;
         std::vector<StringView> elements;
+        Packed packed = Packed::NONE;
+
+        // -1, if --MAXLEN is not specified.
+        long long maxlen = -1;
+
+        // Whether to trim approximately, i.e. --MAXLEN n ~.
+        bool approx = false;
     };
 
+    friend class PrepareCommand;
+    friend class PatchCommand;
+    friend class ExecCommand;
+    friend struct PreparedOp;
+
+    long long _run(RedisModuleCtx *ctx, const Args &args) const;
+
     Args _parse_args(RedisModuleString **argv, int argc) const;
 
+    int _parse_opts(RedisModuleString **argv, int argc, Args &args) const;
+
+    Args::Packed _parse_packed(const StringView &packed) const;
+
+    long long _append_field(MutableFieldRef &field, const Args &args) const;
+
+    // Drop the oldest elements, if the array exceeds maxlen.
+    long long _trim(MutableFieldRef &field, long long maxlen, bool approx) const;
+
     long long _append(MutableFieldRef &field, const std::vector<StringView> &elements) const;
 
-    void _append_arr(MutableFieldRef &field, const StringView &val) const;
+    void _append_arr(MutableFieldRef &field, const std::vector<StringView> &elements) const;
 
     long long _append_str(MutableFieldRef &field, const std::vector<StringView> &elements) const;
 
-    void _add_msg(MutableFieldRef &field, const StringView &val) const;
+    long long _append_packed(MutableFieldRef &field,
+                                const StringView &blob,
+                                Args::Packed packed) const;
 };
 
 }
@@ -0,0 +1,113 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "apply_delta_command.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "path.h"
+#include "field_mask.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int ApplyDeltaCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
+        assert(key);
+
+        _apply(*key, args);
+
+        RedisModule_ReplyWithLongLong(ctx, args.mask.paths_size());
+
+        RedisModule_ReplicateVerbatim(ctx);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+ApplyDeltaCommand::Args ApplyDeltaCommand::_parse_args(RedisModuleString **argv,
+        int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 5) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.key_name = argv[1];
+    args.type = Path(argv[2]).type();
+    args.mask = _parse_mask(args.type, argv[3]);
+    args.values = RedisProtobuf::instance().proto_factory()->create(args.type, argv[4]);
+    assert(args.values);
+
+    return args;
+}
+
+gp::FieldMask ApplyDeltaCommand::_parse_mask(const std::string &type,
+        const StringView &mask) const {
+    const auto *desc = RedisProtobuf::instance().proto_factory()->descriptor(type);
+    if (desc == nullptr) {
+        throw Error("unknown protobuf type: " + type);
+    }
+
+    // Validate all paths before modifying the message.
+    return field_mask::parse(mask, desc);
+}
+
+void ApplyDeltaCommand::_apply(RedisModuleKey &key, const Args &args) const {
+    auto &m = RedisProtobuf::instance();
+
+    if (!api::key_exists(&key, m.type())) {
+        auto msg = m.proto_factory()->create(args.type);
+        assert(msg);
+
+        field_mask::merge(*args.values, args.mask, *msg);
+
+        if (RedisModule_ModuleTypeSetValue(&key, m.type(), msg.get()) != REDISMODULE_OK) {
+            throw Error("failed to set message");
+        }
+
+        msg.release();
+    } else {
+        auto *msg = api::get_msg_by_key(&key);
+        assert(msg != nullptr);
+
+        if (msg->GetTypeName() != args.type) {
+            throw Error("type mismatch");
+        }
+
+        field_mask::merge(*args.values, args.mask, *msg);
+    }
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,67 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_APPLY_DELTA_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_APPLY_DELTA_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include <google/protobuf/field_mask.pb.h>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.APPLYDELTA key type mask values
+// mask:    Comma separated paths of fields, i.e. the first item of PB.DIFF's reply.
+// values:  Serialized message (binary or JSON) of *type*, i.e. the second item of
+//          PB.DIFF's reply. Fields in mask, but not set in values, are cleared.
+// return:  Integer reply: the number of paths in the mask. If key doesn't exist,
+//          the delta is applied to an empty message.
+// error:   If the type doesn't match the protobuf message type of the key,
+//          or the mask or values is invalid, return an error reply.
+class ApplyDeltaCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        RedisModuleString *key_name;
+
+        std::string type;
+
+        gp::FieldMask mask;
+
+        MsgUPtr values;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    gp::FieldMask _parse_mask(const std::string &type, const StringView &mask) const;
+
+    void _apply(RedisModuleKey &key, const Args &args) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_APPLY_DELTA_COMMANDS_H
@@ -26,6 +26,22 @@
 #include "merge_command.h"
 #include "import_command.h"
 #include "last_import_command.h"
+#include "mscan_command.h"
+#include "mget_command.h"
+#include "mset_command.h"
+#include "prepare_command.h"
+#include "exec_command.h"
+#include "incrby_command.h"
+#include "patch_command.h"
+#include "diff_command.h"
+#include "apply_delta_command.h"
+#include "trim_command.h"
+#include "pop_command.h"
+#include "scan_command.h"
+#include "index_command.h"
+#include "find_command.h"
+#include "keys_command.h"
+#include "agg_command.h"
 
 namespace sw {
 
@@ -178,6 +194,240 @@ void create_commands(RedisModuleCtx *ctx) {
                 1) == REDISMODULE_ERR) {
         throw Error("failed to create PB.LASTIMPORT command");
     }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.MSCAN",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    MScanCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("failed to create PB.MSCAN command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.MGET",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    MGetCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly getkeys-api",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("failed to create PB.MGET command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.MSET",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    MSetCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom getkeys-api",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.MSET command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.PREPARE",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    PrepareCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("failed to create PB.PREPARE command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.EXEC",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    ExecCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                2,
+                2,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.EXEC command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.EXEC_RO",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    ExecCommand cmd(true);
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                2,
+                2,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.EXEC_RO command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.INCRBY",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    IncrbyCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.INCRBY command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.INCRBYFLOAT",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    IncrbyCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.INCRBYFLOAT command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.PATCH",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    PatchCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.PATCH command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.DIFF",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    DiffCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly getkeys-api",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.DIFF command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.APPLYDELTA",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    ApplyDeltaCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.APPLYDELTA command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.TRIM",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    TrimCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.TRIM command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.POP",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    PopCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.POP command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.SCAN",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    ScanCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.SCAN command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.INDEX",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    IndexCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "write deny-oom",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.INDEX command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.FIND",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    FindCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.FIND command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.KEYS",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    KeysCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                0,
+                0,
+                0) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.KEYS command");
+    }
+
+    if (RedisModule_CreateCommand(ctx,
+                "PB.AGG",
+                [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                    AggCommand cmd;
+                    return cmd.run(ctx, argv, argc);
+                },
+                "readonly",
+                1,
+                1,
+                1) == REDISMODULE_ERR) {
+        throw Error("fail to create PB.AGG command");
+    }
 }
 
 }
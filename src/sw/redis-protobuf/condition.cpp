@@ -0,0 +1,170 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "condition.h"
+#include "errors.h"
+#include "field_ref.h"
+#include "field_type.h"
+
+namespace {
+
+using sw::redis::pb::gp::FieldDescriptor;
+using sw::redis::pb::ConstFieldRef;
+using sw::redis::pb::Error;
+using sw::redis::pb::FieldAccess;
+using sw::redis::pb::FieldKind;
+using sw::redis::pb::FieldType;
+using sw::redis::pb::StringView;
+
+enum class Ordering {
+    LESS = 0,
+    EQUAL,
+    GREATER,
+    // e.g. NaN
+    UNORDERED
+};
+
+template <FieldDescriptor::CppType T, FieldKind K>
+struct CompareHandler {
+    static Ordering run(const ConstFieldRef &field, const StringView &value) {
+        auto lhs = FieldAccess<T, K>::get(field);
+        auto rhs = FieldType<T>::parse(field, value);
+
+        if (lhs < rhs) {
+            return Ordering::LESS;
+        } else if (rhs < lhs) {
+            return Ordering::GREATER;
+        } else if (lhs == rhs) {
+            return Ordering::EQUAL;
+        } else {
+            return Ordering::UNORDERED;
+        }
+    }
+};
+
+template <FieldKind K>
+struct CompareHandler<FieldDescriptor::CPPTYPE_MESSAGE, K> {
+    static Ordering run(const ConstFieldRef &, const StringView &) {
+        throw Error("cannot compare message field");
+    }
+};
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int Condition::parse(RedisModuleString **argv, int argc, int pos) {
+    if (pos + 1 >= argc) {
+        throw Error("syntax error");
+    }
+
+    // The type is unknown yet.
+    _path = Path(StringView(""), argv[pos]);
+    _op = _parse_op(argv[pos + 1]);
+    pos += 2;
+
+    if (_op != Op::EXISTS) {
+        if (pos >= argc) {
+            throw Error("syntax error");
+        }
+
+        auto value = StringView(argv[pos]);
+        _value.assign(value.data(), value.size());
+        ++pos;
+    }
+
+    return pos;
+}
+
+bool Condition::eval(const gp::Message &msg) const {
+    assert(!empty());
+
+    ConstFieldRef field(&msg, Path(msg.GetTypeName()));
+    for (const auto &name : _path.fields()) {
+        field.descend(name);
+    }
+
+    if (field.missing()) {
+        return _op == Op::NE;
+    }
+
+    if (_op == Op::EXISTS) {
+        return true;
+    }
+
+    if ((field.is_map() && !field.is_map_element())
+            || (field.is_array() && !field.is_array_element())) {
+        throw Error("cannot compare array or map field");
+    }
+
+    using Func = Ordering (*)(const ConstFieldRef &, const StringView &);
+    static const DispatchTable<CompareHandler, Func> table;
+
+    auto ordering = table.get(field)(field, _value);
+    switch (_op) {
+    case Op::EQ:
+        return ordering == Ordering::EQUAL;
+
+    case Op::NE:
+        return ordering != Ordering::EQUAL;
+
+    case Op::LT:
+        return ordering == Ordering::LESS;
+
+    case Op::LE:
+        return ordering == Ordering::LESS || ordering == Ordering::EQUAL;
+
+    case Op::GT:
+        return ordering == Ordering::GREATER;
+
+    case Op::GE:
+        return ordering == Ordering::GREATER || ordering == Ordering::EQUAL;
+
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+Condition::Op Condition::_parse_op(const StringView &op) const {
+    if (util::str_case_equal(op, "EQ")) {
+        return Op::EQ;
+    } else if (util::str_case_equal(op, "NE")) {
+        return Op::NE;
+    } else if (util::str_case_equal(op, "LT")) {
+        return Op::LT;
+    } else if (util::str_case_equal(op, "LE")) {
+        return Op::LE;
+    } else if (util::str_case_equal(op, "GT")) {
+        return Op::GT;
+    } else if (util::str_case_equal(op, "GE")) {
+        return Op::GE;
+    } else if (util::str_case_equal(op, "EXISTS")) {
+        return Op::EXISTS;
+    } else {
+        throw Error("unknown condition op: " + std::string(op.data(), op.size()));
+    }
+}
+
+}
+
+}
+
+}
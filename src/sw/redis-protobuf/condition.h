@@ -0,0 +1,77 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_CONDITION_H
+#define SEWENEW_REDISPROTOBUF_CONDITION_H
+
+#include "module_api.h"
+#include <string>
+#include "utils.h"
+#include "path.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// A condition on a field of a message, i.e. path op [value], e.g. /sub/i GT 10.
+//
+// Supported ops are EQ, NE, LT, LE, GT, GE, which compare the field with the
+// value, and EXISTS, which takes no value, and checks whether the path refers
+// to an existing array element or map element. A condition on a missing
+// element is always false, except NE.
+class Condition {
+public:
+    enum class Op {
+        EQ = 0,
+        NE,
+        LT,
+        LE,
+        GT,
+        GE,
+        EXISTS,
+        NONE
+    };
+
+    // Parse the condition from argv[pos], and return the position
+    // of the next argument.
+    int parse(RedisModuleString **argv, int argc, int pos);
+
+    bool empty() const {
+        return _op == Op::NONE;
+    }
+
+    bool eval(const gp::Message &msg) const;
+
+private:
+    Op _parse_op(const StringView &op) const;
+
+    Op _op = Op::NONE;
+
+    // Only fields are used, the type is the one of the message to be evaluated.
+    Path _path;
+
+    std::string _value;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_CONDITION_H
@@ -32,12 +32,15 @@ namespace pb {
 // command: PB.DEL key type [path]
 // return:  Integer reply: return 1, if the key exists. 0, otherwise.
 // error:   If the path doesn't exist, or the corresponding field is not an array,
-//          or map or the message itself, return an error reply.
+//          or map or the message itself, return an error reply. If the path is an
+//          array slice, e.g. /arr/[1:3], delete all elements in the slice.
 class DelCommand {
 public:
     int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
 
 private:
+    friend class PatchCommand;
+
     struct Args {
         RedisModuleString *key_name;
         Path path;
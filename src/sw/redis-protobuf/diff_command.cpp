@@ -0,0 +1,196 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "diff_command.h"
+#include <vector>
+#include <google/protobuf/util/field_mask_util.h>
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "path.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int DiffCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        if (RedisModule_IsKeysPositionRequest(ctx)) {
+            _reply_with_keys(ctx, argv, argc);
+
+            return REDISMODULE_OK;
+        }
+
+        auto args = _parse_args(argv, argc);
+
+        auto to = _get_msg(ctx, args.key_name, args.type);
+        assert(to);
+
+        MsgUPtr from;
+        if (args.blob) {
+            from = RedisProtobuf::instance().proto_factory()->create(args.type,
+                                                                        StringView(args.other));
+        } else {
+            from = _get_msg(ctx, args.other, args.type);
+        }
+        assert(from);
+
+        gp::util::MessageDifferencer differencer;
+        gp::FieldMask mask;
+        _diff(differencer, *from, *to, "", mask);
+
+        // Only keep the changed fields. Fields in the mask, but not set in the delta,
+        // will be cleared by PB.APPLYDELTA.
+        if (mask.paths_size() == 0) {
+            to->Clear();
+        } else {
+            gp::util::FieldMaskUtil::TrimMessage(mask, to.get());
+        }
+
+        std::string values;
+        if (!to->SerializeToString(&values)) {
+            throw Error("failed to serialize delta");
+        }
+
+        auto paths = gp::util::FieldMaskUtil::ToString(mask);
+
+        RedisModule_ReplyWithArray(ctx, 2);
+        RedisModule_ReplyWithStringBuffer(ctx, paths.data(), paths.size());
+        RedisModule_ReplyWithStringBuffer(ctx, values.data(), values.size());
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+DiffCommand::Args DiffCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 4 && argc != 5) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.key_name = argv[1];
+
+    auto pos = 2;
+    if (argc == 5) {
+        if (!util::str_case_equal(StringView(argv[pos]), "--BLOB")) {
+            throw Error("syntax error");
+        }
+
+        args.blob = true;
+        ++pos;
+    }
+
+    args.type = Path(argv[pos]).type();
+    args.other = argv[pos + 1];
+
+    return args;
+}
+
+void DiffCommand::_reply_with_keys(RedisModuleCtx *ctx,
+        RedisModuleString **argv,
+        int argc) const {
+    auto args = _parse_args(argv, argc);
+
+    RedisModule_KeyAtPos(ctx, 1);
+
+    if (!args.blob) {
+        RedisModule_KeyAtPos(ctx, argc - 1);
+    }
+}
+
+MsgUPtr DiffCommand::_get_msg(RedisModuleCtx *ctx,
+        RedisModuleString *key_name,
+        const std::string &type) const {
+    auto &m = RedisProtobuf::instance();
+
+    auto key = api::open_key(ctx, key_name, api::KeyMode::READONLY);
+    if (!api::key_exists(key.get(), m.type())) {
+        return m.proto_factory()->create(type);
+    }
+
+    auto *msg = api::get_msg_by_key(key.get());
+    assert(msg != nullptr);
+
+    if (msg->GetTypeName() != type) {
+        throw Error("type mismatch");
+    }
+
+    // Copy it, since the key will be closed, and the copy will be trimmed.
+    MsgUPtr copy(msg->New());
+    copy->CopyFrom(*msg);
+
+    return copy;
+}
+
+bool DiffCommand::_diff(gp::util::MessageDifferencer &differencer,
+        const gp::Message &from,
+        const gp::Message &to,
+        const std::string &prefix,
+        gp::FieldMask &mask) const {
+    const auto *desc = to.GetDescriptor();
+    const auto *from_reflection = from.GetReflection();
+    const auto *to_reflection = to.GetReflection();
+
+    auto changed = false;
+    for (int idx = 0; idx != desc->field_count(); ++idx) {
+        const auto *field = desc->field(idx);
+        assert(field != nullptr);
+
+        auto path = prefix + field->name();
+
+        if (!field->is_repeated()
+                && field->cpp_type() == gp::FieldDescriptor::CPPTYPE_MESSAGE
+                && from_reflection->HasField(from, field)
+                && to_reflection->HasField(to, field)) {
+            // Both have the sub message, compare them field by field,
+            // so that the delta only has the changed sub fields.
+            if (_diff(differencer,
+                        from_reflection->GetMessage(from, field),
+                        to_reflection->GetMessage(to, field),
+                        path + ".",
+                        mask)) {
+                changed = true;
+            }
+
+            continue;
+        }
+
+        std::vector<const gp::FieldDescriptor *> fields = {field};
+        if (!differencer.CompareWithFields(from, to, fields, fields)) {
+            mask.add_paths(path);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+}
+
+}
+
+}
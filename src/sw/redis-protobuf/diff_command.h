@@ -0,0 +1,80 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_DIFF_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_DIFF_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include <google/protobuf/field_mask.pb.h>
+#include <google/protobuf/util/message_differencer.h>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.DIFF key [--BLOB] type other
+// return:  Array reply: a delta that turns the message of *other* into the message
+//          of *key*. The first item is the field mask, i.e. comma separated paths
+//          of changed fields, and the second item is a serialized message of *type*
+//          holding the new values of these fields. Apply the delta with PB.APPLYDELTA.
+//          *other* is a key name, or a serialized message (binary or JSON)
+//          if --BLOB is specified. A non-existent key is treated as an empty message.
+// error:   If the type doesn't match the protobuf message type of the keys,
+//          or *other* is not a valid message, return an error reply.
+class DiffCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        RedisModuleString *key_name;
+
+        std::string type;
+
+        // Key name or blob.
+        RedisModuleString *other;
+
+        bool blob = false;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    // Reply with the positions of keys for Redis Cluster.
+    void _reply_with_keys(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+    MsgUPtr _get_msg(RedisModuleCtx *ctx,
+                        RedisModuleString *key_name,
+                        const std::string &type) const;
+
+    // Collect paths of fields of *from* that differ from *to*.
+    bool _diff(gp::util::MessageDifferencer &differencer,
+                const gp::Message &from,
+                const gp::Message &to,
+                const std::string &prefix,
+                gp::FieldMask &mask) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_DIFF_COMMANDS_H
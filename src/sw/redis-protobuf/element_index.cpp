@@ -0,0 +1,198 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "element_index.h"
+#include <cassert>
+#include "errors.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int ElementIndex::find(const gp::Message &root,
+        const gp::Message &parent,
+        const gp::FieldDescriptor *field,
+        const gp::FieldDescriptor *key_field,
+        const StringView &val) {
+    assert(field != nullptr && key_field != nullptr);
+
+    switch (key_field->cpp_type()) {
+    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
+    case gp::FieldDescriptor::CPPTYPE_FLOAT:
+    case gp::FieldDescriptor::CPPTYPE_MESSAGE:
+        throw Error("invalid predicate field: " + key_field->name());
+
+    default:
+        break;
+    }
+
+    auto key = _normalize(key_field, val);
+
+    auto size = parent.GetReflection()->FieldSize(parent, field);
+    if (size < MIN_INDEXED_SIZE) {
+        // Scanning a small array is cheaper than building an index for it. Also, arrays
+        // of temporary messages, e.g. the empty message that a condition is checked
+        // against, are never indexed, since their indexes are not invalidated when
+        // they're freed.
+        for (auto idx = 0; idx != size; ++idx) {
+            if (_match(parent, field, key_field, idx, key)) {
+                return idx;
+            }
+        }
+
+        return -1;
+    }
+
+    auto root_iter = _indexes.find(&root);
+    if (root_iter == _indexes.end()) {
+        if (_indexes.size() >= MAX_INDEXED_MSGS) {
+            _indexes.clear();
+        }
+
+        root_iter = _indexes.emplace(&root, std::map<IndexKey, Index>()).first;
+    }
+
+    auto &index = root_iter->second[IndexKey(&parent, field, key_field)];
+    if (!index.built) {
+        _build(index, parent, field, key_field);
+    }
+
+    auto iter = index.positions.find(key);
+    if (iter == index.positions.end()) {
+        return -1;
+    }
+
+    if (!_match(parent, field, key_field, iter->second, key)) {
+        // Not supposed to happen, since indexes are invalidated on modification.
+        // Rebuild it anyway, in case we miss some modification.
+        _build(index, parent, field, key_field);
+
+        iter = index.positions.find(key);
+        if (iter == index.positions.end()) {
+            return -1;
+        }
+    }
+
+    return iter->second;
+}
+
+void ElementIndex::invalidate(const gp::Message *root) {
+    _indexes.erase(root);
+}
+
+void ElementIndex::_build(Index &index,
+        const gp::Message &parent,
+        const gp::FieldDescriptor *field,
+        const gp::FieldDescriptor *key_field) const {
+    index.positions.clear();
+    index.built = true;
+
+    const auto *reflection = parent.GetReflection();
+    auto size = reflection->FieldSize(parent, field);
+    index.positions.reserve(size);
+    for (auto idx = 0; idx != size; ++idx) {
+        const auto &element = reflection->GetRepeatedMessage(parent, field, idx);
+
+        // If more than one elements have the same key, index the first one.
+        index.positions.emplace(_key(element, key_field), idx);
+    }
+}
+
+bool ElementIndex::_match(const gp::Message &parent,
+        const gp::FieldDescriptor *field,
+        const gp::FieldDescriptor *key_field,
+        int idx,
+        const std::string &key) const {
+    const auto *reflection = parent.GetReflection();
+    if (idx >= reflection->FieldSize(parent, field)) {
+        return false;
+    }
+
+    const auto &element = reflection->GetRepeatedMessage(parent, field, idx);
+
+    return _key(element, key_field) == key;
+}
+
+std::string ElementIndex::_key(const gp::Message &element,
+        const gp::FieldDescriptor *key_field) const {
+    const auto *reflection = element.GetReflection();
+    switch (key_field->cpp_type()) {
+    case gp::FieldDescriptor::CPPTYPE_INT32:
+        return std::to_string(reflection->GetInt32(element, key_field));
+
+    case gp::FieldDescriptor::CPPTYPE_INT64:
+        return std::to_string(reflection->GetInt64(element, key_field));
+
+    case gp::FieldDescriptor::CPPTYPE_UINT32:
+        return std::to_string(reflection->GetUInt32(element, key_field));
+
+    case gp::FieldDescriptor::CPPTYPE_UINT64:
+        return std::to_string(reflection->GetUInt64(element, key_field));
+
+    case gp::FieldDescriptor::CPPTYPE_BOOL:
+        return std::to_string(static_cast<int>(reflection->GetBool(element, key_field)));
+
+    case gp::FieldDescriptor::CPPTYPE_ENUM:
+        return std::to_string(reflection->GetEnumValue(element, key_field));
+
+    case gp::FieldDescriptor::CPPTYPE_STRING:
+        return reflection->GetString(element, key_field);
+
+    default:
+        assert(false);
+        return "";
+    }
+}
+
+std::string ElementIndex::_normalize(const gp::FieldDescriptor *key_field,
+        const StringView &val) const {
+    try {
+        switch (key_field->cpp_type()) {
+        case gp::FieldDescriptor::CPPTYPE_INT32:
+        case gp::FieldDescriptor::CPPTYPE_ENUM:
+            return std::to_string(util::sv_to_int32(val));
+
+        case gp::FieldDescriptor::CPPTYPE_INT64:
+            return std::to_string(util::sv_to_int64(val));
+
+        case gp::FieldDescriptor::CPPTYPE_UINT32:
+            return std::to_string(util::sv_to_uint32(val));
+
+        case gp::FieldDescriptor::CPPTYPE_UINT64:
+            return std::to_string(util::sv_to_uint64(val));
+
+        case gp::FieldDescriptor::CPPTYPE_BOOL:
+            return std::to_string(static_cast<int>(util::sv_to_bool(val)));
+
+        case gp::FieldDescriptor::CPPTYPE_STRING:
+            return util::sv_to_string(val);
+
+        default:
+            assert(false);
+            return "";
+        }
+    } catch (const Error &e) {
+        throw Error("invalid predicate value: " + util::sv_to_string(val));
+    }
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,109 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_ELEMENT_INDEX_H
+#define SEWENEW_REDISPROTOBUF_ELEMENT_INDEX_H
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <google/protobuf/message.h>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Index from the value of a key field to the position of the element in an
+// array of messages, so that we can find elements with path like
+// /items[id=42] without scanning the whole array.
+//
+// Indexes are built lazily, and kept per (message, array field, key field).
+// Since protobuf doesn't notify us on modification, indexes of a message are
+// invalidated when its key, which is opened for writing, is closed, or when
+// a message is loaded. If an element moves, or a duplicate key is added, the
+// index is rebuilt, so that we always find the first matching element.
+//
+// Small arrays are scanned instead of being indexed. So are arrays of temporary
+// messages, which are usually empty, and would otherwise leave indexes keyed by
+// freed addresses.
+//
+// The free callback might be called in a background thread, so it doesn't
+// remove indexes of freed messages. Instead, the number of indexed messages is
+// limited, and indexes of a message allocated at the address of a freed one
+// are invalidated as described above.
+class ElementIndex {
+public:
+    // Return the position of the first element of parent.field, whose key_field
+    // equals to *val*, or -1 if no such element.
+    int find(const gp::Message &root,
+            const gp::Message &parent,
+            const gp::FieldDescriptor *field,
+            const gp::FieldDescriptor *key_field,
+            const StringView &val);
+
+    // Remove indexes of the root message, since it might have been modified.
+    void invalidate(const gp::Message *root);
+
+private:
+    struct Index {
+        bool built = false;
+
+        std::unordered_map<std::string, int> positions;
+    };
+
+    // (parent message, array field, key field)
+    using IndexKey = std::tuple<const gp::Message *,
+                                const gp::FieldDescriptor *,
+                                const gp::FieldDescriptor *>;
+
+    void _build(Index &index,
+            const gp::Message &parent,
+            const gp::FieldDescriptor *field,
+            const gp::FieldDescriptor *key_field) const;
+
+    bool _match(const gp::Message &parent,
+            const gp::FieldDescriptor *field,
+            const gp::FieldDescriptor *key_field,
+            int idx,
+            const std::string &key) const;
+
+    // Convert value of the key field to string.
+    std::string _key(const gp::Message &element, const gp::FieldDescriptor *key_field) const;
+
+    // Convert *val* to the same format as _key does, e.g. '042' and '42' are the same int.
+    std::string _normalize(const gp::FieldDescriptor *key_field, const StringView &val) const;
+
+    // Arrays with fewer elements are scanned instead of being indexed.
+    static const int MIN_INDEXED_SIZE = 16;
+
+    // Limit the number of indexed root messages.
+    static const std::size_t MAX_INDEXED_MSGS = 1024;
+
+    // root message -> indexes of the root message and its sub-messages.
+    std::unordered_map<const gp::Message *, std::map<IndexKey, Index>> _indexes;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_ELEMENT_INDEX_H
@@ -0,0 +1,155 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "exec_command.h"
+#include <vector>
+#include "errors.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int ExecCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        if (argc < 3) {
+            throw WrongArityError();
+        }
+
+        auto handle = util::try_sv_to_int64(argv[1]);
+        if (!handle) {
+            throw Error("invalid handle");
+        }
+
+        auto &op = prepared_ops().get(*handle);
+        if (_readonly && op.cmd != PreparedOp::Cmd::GET) {
+            throw Error("PB.EXEC_RO only runs prepared GET");
+        }
+
+        switch (op.cmd) {
+        case PreparedOp::Cmd::GET:
+            _exec_get(ctx, op, argv, argc);
+            break;
+
+        case PreparedOp::Cmd::SET:
+            _exec_set(ctx, op, argv, argc);
+            break;
+
+        case PreparedOp::Cmd::APPEND:
+            _exec_append(ctx, op, argv, argc);
+            break;
+
+        default:
+            assert(false);
+        }
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+// NOTE: Commands are run in the main thread, so we fill the key and values into
+// the prepared arguments in place, instead of copying the parsed path each time.
+
+void ExecCommand::_exec_get(RedisModuleCtx *ctx,
+        PreparedOp &op,
+        RedisModuleString **argv,
+        int argc) const {
+    if (argc != 3) {
+        throw WrongArityError();
+    }
+
+    auto &args = op.get_args;
+    args.key_name = argv[2];
+
+    get_reply::reply_with_key(ctx, args);
+}
+
+void ExecCommand::_exec_set(RedisModuleCtx *ctx,
+        PreparedOp &op,
+        RedisModuleString **argv,
+        int argc) const {
+    if (argc != 4) {
+        throw WrongArityError();
+    }
+
+    auto &args = op.set_args;
+    args.key_name = argv[2];
+    args.val = StringView(argv[3]);
+
+    SetCommand set_cmd;
+    auto res = set_cmd._run(ctx, args);
+
+    RedisModule_ReplyWithLongLong(ctx, res);
+
+    _replicate(ctx, "PB.SET", op, argv, argc);
+}
+
+void ExecCommand::_exec_append(RedisModuleCtx *ctx,
+        PreparedOp &op,
+        RedisModuleString **argv,
+        int argc) const {
+    if (argc < 4) {
+        throw WrongArityError();
+    }
+
+    auto &args = op.append_args;
+    if (args.packed != AppendCommand::Args::Packed::NONE && argc != 4) {
+        throw Error("only one blob can be specified with --PACKED");
+    }
+
+    args.key_name = argv[2];
+    args.elements.clear();
+    for (auto idx = 3; idx != argc; ++idx) {
+        args.elements.emplace_back(argv[idx]);
+    }
+
+    AppendCommand append_cmd;
+    auto len = append_cmd._run(ctx, args);
+
+    RedisModule_ReplyWithLongLong(ctx, len);
+
+    _replicate(ctx, "PB.APPEND", op, argv, argc);
+}
+
+void ExecCommand::_replicate(RedisModuleCtx *ctx,
+        const char *cmd,
+        const PreparedOp &op,
+        RedisModuleString **argv,
+        int argc) const {
+    // key, prepared arguments, values
+    std::vector<RedisModuleString *> args;
+    args.reserve(op.argv.size() + argc - 2);
+    args.push_back(argv[2]);
+    args.insert(args.end(), op.argv.begin(), op.argv.end());
+    args.insert(args.end(), argv + 3, argv + argc);
+
+    RedisModule_Replicate(ctx, cmd, "v", args.data(), args.size());
+}
+
+}
+
+}
+
+}
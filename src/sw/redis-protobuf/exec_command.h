@@ -0,0 +1,77 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_EXEC_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_EXEC_COMMANDS_H
+
+#include "module_api.h"
+#include "utils.h"
+#include "prepared_ops.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.EXEC handle key [value [value ...]]
+//          PB.EXEC_RO handle key
+// return:  The same reply as the prepared operation, i.e. PB.GET, PB.SET
+//          or PB.APPEND, with the given key and values.
+// error:   If the handle is unknown, or the number of values doesn't match
+//          the prepared operation, or the operation fails, return an error reply.
+//          PB.EXEC_RO only runs prepared GET, and it's flagged as readonly,
+//          so that it can be sent to read-only replicas.
+class ExecCommand {
+public:
+    explicit ExecCommand(bool readonly = false) : _readonly(readonly) {}
+
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    void _exec_get(RedisModuleCtx *ctx,
+            PreparedOp &op,
+            RedisModuleString **argv,
+            int argc) const;
+
+    void _exec_set(RedisModuleCtx *ctx,
+            PreparedOp &op,
+            RedisModuleString **argv,
+            int argc) const;
+
+    void _exec_append(RedisModuleCtx *ctx,
+            PreparedOp &op,
+            RedisModuleString **argv,
+            int argc) const;
+
+    // Replicate the equivalent command, since replicas and AOF
+    // know nothing about the handle.
+    void _replicate(RedisModuleCtx *ctx,
+            const char *cmd,
+            const PreparedOp &op,
+            RedisModuleString **argv,
+            int argc) const;
+
+    bool _readonly;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_EXEC_COMMANDS_H
@@ -0,0 +1,838 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "field_index.h"
+#include <cassert>
+#include <cmath>
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "field_ref.h"
+#include "field_type.h"
+
+namespace {
+
+using sw::redis::pb::gp::FieldDescriptor;
+using sw::redis::pb::gp::Message;
+using sw::redis::pb::ConstFieldRef;
+using sw::redis::pb::FieldAccess;
+using sw::redis::pb::FieldKind;
+using sw::redis::pb::RedisProtobuf;
+using sw::redis::pb::api::KeyMode;
+using sw::redis::pb::api::get_msg_by_key;
+using sw::redis::pb::api::open_key;
+
+bool is_numeric(FieldDescriptor::CppType type);
+
+double numeric_value(const ConstFieldRef &field);
+
+std::string tag_value(const ConstFieldRef &field);
+
+// Return nullptr, if the key doesn't exist, or it's not of our type.
+const Message* lookup(RedisModuleCtx *ctx, RedisModuleString *key_name);
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+constexpr std::chrono::seconds FieldIndexes::RESCAN_INTERVAL;
+
+FieldIndexes::~FieldIndexes() {
+    if (!_worker) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_worker->mtx);
+
+        _worker->stop = true;
+    }
+
+    _worker->cv.notify_one();
+
+    // NOTE: Do NOT join the thread. On exit, the main thread holds the GIL, and
+    // the background thread might be waiting for it.
+    _worker_thread.detach();
+}
+
+void FieldIndexes::create(RedisModuleCtx *ctx,
+        const std::string &name,
+        const Path &path,
+        Kind kind) {
+    kind = _validate(path, kind);
+
+    auto &db = _db(ctx);
+    if (db.indexes.find(name) != db.indexes.end()) {
+        throw Error("index already exists");
+    }
+
+    auto &index = db.indexes[name];
+    index.path = path;
+    index.kind = kind;
+    index.built_by_scan = _request_scan(db);
+
+    _wake_up_worker();
+}
+
+bool FieldIndexes::drop(RedisModuleCtx *ctx, const std::string &name) {
+    auto *db = _find_db(ctx);
+    if (db == nullptr) {
+        return false;
+    }
+
+    auto iter = db->indexes.find(name);
+    if (iter == db->indexes.end()) {
+        return false;
+    }
+
+    // Clients waiting for the index get an error, since it no longer exists.
+    _unblock(iter->second);
+
+    db->indexes.erase(iter);
+
+    _shrink(ctx);
+
+    return true;
+}
+
+auto FieldIndexes::kind(RedisModuleCtx *ctx, const std::string &name) const -> Kind {
+    return _index(_find_db(ctx), name).kind;
+}
+
+long long FieldIndexes::size(RedisModuleCtx *ctx, const std::string &name) const {
+    const auto &index = _index(_find_db(ctx), name);
+    if (index.built_by_scan != 0) {
+        throw Error("index is being built");
+    }
+
+    return index.entries.size();
+}
+
+void FieldIndexes::wait(RedisModuleCtx *ctx,
+        const std::string &name,
+        RedisModuleBlockedClient *bc) {
+    assert(bc != nullptr);
+
+    auto &index = _index(_find_db(ctx), name);
+    index.waiters.push_back(bc);
+
+    if (index.built_by_scan == 0) {
+        _unblock(index);
+    }
+}
+
+std::vector<std::string> FieldIndexes::find(RedisModuleCtx *ctx,
+        const std::string &name,
+        const Range &range,
+        long long offset,
+        long long count) {
+    auto *db = _find_db(ctx);
+    auto &index = _built_index(db, name);
+    if (index.kind != Kind::NUMERIC) {
+        throw Error("not a numeric index");
+    }
+
+    _sync(ctx, *db);
+
+    auto &numbers = index.numbers;
+    auto iter = range.min_exclusive ?
+        numbers.upper_bound(range.min) : numbers.lower_bound(range.min);
+
+    // Stale keys are re-indexed after the walk, so that iterators are not invalidated.
+    std::vector<std::string> keys;
+    std::vector<std::string> stale;
+    for (; iter != numbers.end(); ++iter) {
+        if (iter->first > range.max || (range.max_exclusive && iter->first == range.max)) {
+            break;
+        }
+
+        if (!_collect(ctx, index, *(iter->second), offset, count, keys, stale)) {
+            break;
+        }
+    }
+
+    for (const auto &key : stale) {
+        _reindex(ctx, *db, key);
+    }
+
+    return keys;
+}
+
+std::vector<std::string> FieldIndexes::find(RedisModuleCtx *ctx,
+        const std::string &name,
+        const std::string &tag,
+        long long offset,
+        long long count) {
+    auto *db = _find_db(ctx);
+    auto &index = _built_index(db, name);
+    if (index.kind != Kind::TAG) {
+        throw Error("not a tag index");
+    }
+
+    _sync(ctx, *db);
+
+    auto iter = index.tags.find(tag);
+    if (iter == index.tags.end()) {
+        return {};
+    }
+
+    std::vector<std::string> keys;
+    std::vector<std::string> stale;
+    for (const auto *key : iter->second) {
+        if (!_collect(ctx, index, *key, offset, count, keys, stale)) {
+            break;
+        }
+    }
+
+    for (const auto &key : stale) {
+        _reindex(ctx, *db, key);
+    }
+
+    return keys;
+}
+
+bool FieldIndexes::registered(RedisModuleCtx *ctx, const std::string &type) {
+    auto &db = _db(ctx);
+
+    auto iter = db.registries.find(type);
+    if (iter != db.registries.end()) {
+        return iter->second.built_by_scan == 0;
+    }
+
+    if (RedisProtobuf::instance().proto_factory()->descriptor(type) == nullptr) {
+        _shrink(ctx);
+        throw Error("unknown type: " + type);
+    }
+
+    // Create the registry on first use, and build it in background.
+    auto &registry = db.registries[type];
+    registry.path = Path(type);
+    registry.kind = Kind::REGISTRY;
+    registry.built_by_scan = _request_scan(db);
+
+    _wake_up_worker();
+
+    return false;
+}
+
+void FieldIndexes::wait_registry(RedisModuleCtx *ctx,
+        const std::string &type,
+        RedisModuleBlockedClient *bc) {
+    assert(bc != nullptr);
+
+    auto &db = _db(ctx);
+    auto iter = db.registries.find(type);
+    assert(iter != db.registries.end());
+
+    auto &registry = iter->second;
+    registry.waiters.push_back(bc);
+
+    if (registry.built_by_scan == 0) {
+        _unblock(registry);
+    }
+}
+
+std::vector<std::string> FieldIndexes::keys(RedisModuleCtx *ctx,
+        const std::string &type,
+        const Optional<std::string> &after,
+        long long count,
+        Optional<std::string> &last) {
+    auto &db = _db(ctx);
+
+    auto iter = db.registries.find(type);
+    if (iter == db.registries.end() || iter->second.built_by_scan != 0) {
+        throw Error("keys of the type are being registered");
+    }
+
+    auto &registry = iter->second;
+
+    _sync(ctx, db);
+
+    auto &entries = registry.entries;
+    auto entry_iter = after ? entries.upper_bound(*after) : entries.begin();
+
+    std::vector<std::string> keys;
+    std::vector<std::string> stale;
+    long long offset = 0;
+    for (auto visited = 0LL; entry_iter != entries.end() && visited < count; ++visited) {
+        last = Optional<std::string>(entry_iter->first);
+
+        _collect(ctx, registry, entry_iter->first, offset, -1, keys, stale);
+
+        ++entry_iter;
+    }
+
+    if (entry_iter == entries.end()) {
+        last = Optional<std::string>();
+    }
+
+    for (const auto &key : stale) {
+        _reindex(ctx, db, key);
+    }
+
+    return keys;
+}
+
+void FieldIndexes::touch(RedisModuleCtx *ctx, RedisModuleString *key_name) {
+    auto *db = _find_db(ctx);
+    if (db == nullptr) {
+        // Nothing is indexed.
+        return;
+    }
+
+    if (db->dirty.size() >= MAX_DIRTY_KEYS) {
+        // NOTE: re-index before marking this key, since it hasn't been modified yet.
+        // Only dirty keys are re-indexed, and it never scans the whole database.
+        _reindex_dirty(ctx, *db);
+    }
+
+    db->dirty.insert(util::sv_to_string(StringView(key_name)));
+}
+
+void FieldIndexes::loaded() {
+    if (_dbs.empty()) {
+        return;
+    }
+
+    // We don't know which database the message is loaded into, and which key
+    // it's loaded to. So scan all databases in background to catch up with it.
+    _rescan_all();
+}
+
+auto FieldIndexes::_db(RedisModuleCtx *ctx) -> Db& {
+    return _dbs[RedisModule_GetSelectedDb(ctx)];
+}
+
+auto FieldIndexes::_find_db(RedisModuleCtx *ctx) -> Db* {
+    auto iter = _dbs.find(RedisModule_GetSelectedDb(ctx));
+    if (iter == _dbs.end()) {
+        return nullptr;
+    }
+
+    return &(iter->second);
+}
+
+auto FieldIndexes::_find_db(RedisModuleCtx *ctx) const -> const Db* {
+    auto iter = _dbs.find(RedisModule_GetSelectedDb(ctx));
+    if (iter == _dbs.end()) {
+        return nullptr;
+    }
+
+    return &(iter->second);
+}
+
+auto FieldIndexes::_index(Db *db, const std::string &name) -> Index& {
+    return const_cast<Index &>(static_cast<const FieldIndexes *>(this)->_index(db, name));
+}
+
+auto FieldIndexes::_index(const Db *db, const std::string &name) const -> const Index& {
+    if (db == nullptr) {
+        throw Error("index doesn't exist");
+    }
+
+    auto iter = db->indexes.find(name);
+    if (iter == db->indexes.end()) {
+        throw Error("index doesn't exist");
+    }
+
+    return iter->second;
+}
+
+auto FieldIndexes::_built_index(Db *db, const std::string &name) -> Index& {
+    auto &index = _index(db, name);
+    if (index.built_by_scan != 0) {
+        throw Error("index is being built");
+    }
+
+    return index;
+}
+
+void FieldIndexes::_shrink(RedisModuleCtx *ctx) {
+    auto iter = _dbs.find(RedisModule_GetSelectedDb(ctx));
+    if (iter != _dbs.end() && iter->second.empty()) {
+        _dbs.erase(iter);
+    }
+}
+
+auto FieldIndexes::_validate(const Path &path, Kind kind) const -> Kind {
+    if (path.empty()) {
+        throw Error("empty path");
+    }
+
+    auto msg = RedisProtobuf::instance().proto_factory()->create(path.type());
+    if (!msg) {
+        throw Error("unknown type: " + path.type());
+    }
+
+    ConstFieldRef field(msg.get(), path);
+    if (field.missing()) {
+        throw Error(field.missing_reason());
+    }
+
+    // NOTE: map is also a repeated field.
+    if (field.is_array() || field.is_map()) {
+        throw Error("cannot index repeated field");
+    }
+
+    auto type = field.type();
+    if (type == gp::FieldDescriptor::CPPTYPE_MESSAGE) {
+        throw Error("cannot index message field");
+    }
+
+    switch (kind) {
+    case Kind::NUMERIC:
+        if (!is_numeric(type)) {
+            throw Error("cannot create numeric index on non-numeric field");
+        }
+        break;
+
+    case Kind::TAG:
+        if (type == gp::FieldDescriptor::CPPTYPE_DOUBLE
+                || type == gp::FieldDescriptor::CPPTYPE_FLOAT) {
+            throw Error("cannot create tag index on floating-point field");
+        }
+        break;
+
+    default:
+        kind = is_numeric(type) ? Kind::NUMERIC : Kind::TAG;
+        break;
+    }
+
+    return kind;
+}
+
+void FieldIndexes::_sync(RedisModuleCtx *ctx, Db &db) {
+    _reindex_dirty(ctx, db);
+}
+
+void FieldIndexes::_reindex_dirty(RedisModuleCtx *ctx, Db &db) {
+    auto dirty = std::move(db.dirty);
+    db.dirty.clear();
+
+    for (const auto &key : dirty) {
+        _reindex(ctx, db, key);
+    }
+}
+
+unsigned long long FieldIndexes::_request_scan(Db &db) {
+    if (!db.scanning) {
+        db.scanning = true;
+        db.cursor = "0";
+        ++db.scan_id;
+
+        return db.scan_id;
+    }
+
+    // Keys that have been scanned by the running scan, will be scanned by the next one.
+    db.rescan = true;
+
+    return db.scan_id + 1;
+}
+
+void FieldIndexes::_wake_up_worker() {
+    if (!_worker) {
+        // Start the background thread on first use, so that there's
+        // no overhead if indexes are never used.
+        _worker = std::make_shared<Worker>();
+
+        auto worker = _worker;
+        _worker_thread = std::thread([this, worker]() { this->_work(worker); });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_worker->mtx);
+
+        _worker->wakeup = true;
+    }
+
+    _worker->cv.notify_one();
+}
+
+void FieldIndexes::_work(std::shared_ptr<Worker> worker) {
+    auto *ctx = RedisModule_GetThreadSafeContext(nullptr);
+
+    auto busy = true;
+    while (true) {
+        if (!busy) {
+            std::unique_lock<std::mutex> lock(worker->mtx);
+            auto woken_up = worker->cv.wait_for(lock, RESCAN_INTERVAL,
+                    [&worker]() { return worker->stop || worker->wakeup; });
+
+            if (worker->stop) {
+                break;
+            }
+
+            worker->wakeup = false;
+
+            if (!woken_up) {
+                // Periodically scan databases to catch up with keys written
+                // without our commands, e.g. RENAME and MOVE.
+                lock.unlock();
+
+                RedisModule_ThreadSafeContextLock(ctx);
+                _rescan_all();
+                RedisModule_ThreadSafeContextUnlock(ctx);
+            }
+        }
+
+        // Only hold the GIL while scanning a batch of keys.
+        RedisModule_ThreadSafeContextLock(ctx);
+
+        {
+            std::lock_guard<std::mutex> lock(worker->mtx);
+            if (worker->stop) {
+                // FieldIndexes might have been destroyed.
+                RedisModule_ThreadSafeContextUnlock(ctx);
+                break;
+            }
+        }
+
+        try {
+            busy = _scan_batch(ctx);
+        } catch (const std::exception &e) {
+            RedisModule_Log(ctx, "warning", "failed to scan keys for indexes: %s", e.what());
+            busy = false;
+        }
+
+        RedisModule_ThreadSafeContextUnlock(ctx);
+    }
+
+    RedisModule_FreeThreadSafeContext(ctx);
+}
+
+bool FieldIndexes::_scan_batch(RedisModuleCtx *ctx) {
+    for (auto &ele : _dbs) {
+        auto &db = ele.second;
+        if (!db.scanning) {
+            continue;
+        }
+
+        if (RedisModule_SelectDb(ctx, ele.first) != REDISMODULE_OK) {
+            throw Error("failed to select db: " + std::to_string(ele.first));
+        }
+
+        db.cursor = _scan(ctx, db.cursor, [this, ctx, &db](RedisModuleString *key_name) {
+                    this->_reindex(ctx, db, util::sv_to_string(StringView(key_name)));
+                });
+
+        if (db.cursor == "0") {
+            _finish_scan(db);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void FieldIndexes::_rescan_all() {
+    auto requested = false;
+    for (auto &ele : _dbs) {
+        auto &db = ele.second;
+        if (db.scanning && db.rescan) {
+            // Already requested.
+            continue;
+        }
+
+        _request_scan(db);
+        requested = true;
+    }
+
+    if (requested) {
+        _wake_up_worker();
+    }
+}
+
+void FieldIndexes::_finish_scan(Db &db) {
+    _for_each(db, [this, &db](Index &index) {
+                if (index.built_by_scan != 0 && index.built_by_scan <= db.scan_id) {
+                    index.built_by_scan = 0;
+                    this->_unblock(index);
+                }
+            });
+
+    if (db.rescan) {
+        db.rescan = false;
+        db.cursor = "0";
+        ++db.scan_id;
+    } else {
+        db.scanning = false;
+        db.cursor.clear();
+    }
+}
+
+void FieldIndexes::_unblock(Index &index) {
+    for (auto *bc : index.waiters) {
+        RedisModule_UnblockClient(bc, nullptr);
+    }
+
+    index.waiters.clear();
+}
+
+template <typename Func>
+std::string FieldIndexes::_scan(RedisModuleCtx *ctx, const std::string &cursor, Func &&func) const {
+    api::CallReply reply(RedisModule_Call(ctx, "SCAN", "ccl",
+                cursor.c_str(), "COUNT", SCAN_BATCH));
+    if (!reply
+            || RedisModule_CallReplyType(reply.get()) != REDISMODULE_REPLY_ARRAY
+            || RedisModule_CallReplyLength(reply.get()) != 2) {
+        throw Error("failed to scan keys");
+    }
+
+    // Reply of SCAN: [next cursor, [key1, key2, ...]]
+    std::size_t len = 0;
+    const auto *ptr = RedisModule_CallReplyStringPtr(
+            RedisModule_CallReplyArrayElement(reply.get(), 0), &len);
+    std::string next(ptr, len);
+
+    auto *keys_reply = RedisModule_CallReplyArrayElement(reply.get(), 1);
+    auto num = RedisModule_CallReplyLength(keys_reply);
+    for (std::size_t idx = 0; idx != num; ++idx) {
+        auto *key_reply = RedisModule_CallReplyArrayElement(keys_reply, idx);
+        api::RedisString key_name(RedisModule_CreateStringFromCallReply(key_reply),
+                api::RedisStringDeleter(ctx));
+        if (key_name) {
+            func(key_name.get());
+        }
+    }
+
+    return next;
+}
+
+void FieldIndexes::_reindex(RedisModuleCtx *ctx, Db &db, const std::string &key) {
+    api::RedisString key_name(RedisModule_CreateString(ctx, key.data(), key.size()),
+            api::RedisStringDeleter(ctx));
+
+    const auto *msg = lookup(ctx, key_name.get());
+    _for_each(db, [this, &key, msg](Index &index) {
+                if (msg != nullptr && msg->GetTypeName() == index.path.type()) {
+                    this->_add(index, key, *msg);
+                } else {
+                    this->_remove(index, key);
+                }
+            });
+}
+
+bool FieldIndexes::_entry(const Index &index, const gp::Message &msg, Entry &entry) const {
+    if (index.kind == Kind::REGISTRY) {
+        return true;
+    }
+
+    ConstFieldRef field(&msg, index.path);
+    if (field.missing()) {
+        return false;
+    }
+
+    if (index.kind == Kind::NUMERIC) {
+        entry.number = numeric_value(field);
+
+        // NaN cannot be ordered.
+        return !std::isnan(entry.number);
+    }
+
+    entry.tag = tag_value(field);
+
+    return true;
+}
+
+void FieldIndexes::_add(Index &index, const std::string &key, const gp::Message &msg) const {
+    _remove(index, key);
+
+    Entry entry;
+    if (!_entry(index, msg, entry)) {
+        return;
+    }
+
+    auto iter = index.entries.emplace(key, std::move(entry)).first;
+    const auto *indexed_key = &(iter->first);
+    if (index.kind == Kind::NUMERIC) {
+        index.numbers.emplace(iter->second.number, indexed_key);
+    } else if (index.kind == Kind::TAG) {
+        index.tags[iter->second.tag].insert(indexed_key);
+    }
+}
+
+void FieldIndexes::_remove(Index &index, const std::string &key) const {
+    auto iter = index.entries.find(key);
+    if (iter == index.entries.end()) {
+        return;
+    }
+
+    const auto *indexed_key = &(iter->first);
+    const auto &entry = iter->second;
+    if (index.kind == Kind::NUMERIC) {
+        auto range = index.numbers.equal_range(entry.number);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == indexed_key) {
+                index.numbers.erase(it);
+                break;
+            }
+        }
+    } else if (index.kind == Kind::TAG) {
+        auto tag_iter = index.tags.find(entry.tag);
+        if (tag_iter != index.tags.end()) {
+            tag_iter->second.erase(indexed_key);
+            if (tag_iter->second.empty()) {
+                index.tags.erase(tag_iter);
+            }
+        }
+    }
+
+    index.entries.erase(iter);
+}
+
+bool FieldIndexes::_verify(RedisModuleCtx *ctx, const Index &index, const std::string &key) const {
+    auto iter = index.entries.find(key);
+    if (iter == index.entries.end()) {
+        return false;
+    }
+
+    api::RedisString key_name(RedisModule_CreateString(ctx, key.data(), key.size()),
+            api::RedisStringDeleter(ctx));
+
+    const auto *msg = lookup(ctx, key_name.get());
+
+    // The key might have been deleted, renamed, moved or overwritten by other commands.
+    Entry entry;
+    return msg != nullptr
+        && msg->GetTypeName() == index.path.type()
+        && _entry(index, *msg, entry)
+        && entry.number == iter->second.number
+        && entry.tag == iter->second.tag;
+}
+
+bool FieldIndexes::_collect(RedisModuleCtx *ctx,
+        const Index &index,
+        const std::string &key,
+        long long &offset,
+        long long count,
+        std::vector<std::string> &keys,
+        std::vector<std::string> &stale) const {
+    if (count >= 0 && static_cast<long long>(keys.size()) >= count) {
+        return false;
+    }
+
+    if (!_verify(ctx, index, key)) {
+        stale.push_back(key);
+    } else if (offset > 0) {
+        --offset;
+    } else {
+        keys.push_back(key);
+    }
+
+    return count < 0 || static_cast<long long>(keys.size()) < count;
+}
+
+}
+
+}
+
+}
+
+namespace {
+
+bool is_numeric(FieldDescriptor::CppType type) {
+    switch (type) {
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+        return false;
+
+    default:
+        return true;
+    }
+}
+
+double numeric_value(const ConstFieldRef &field) {
+    switch (field.type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        return FieldAccess<FieldDescriptor::CPPTYPE_INT32, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_INT64:
+        return FieldAccess<FieldDescriptor::CPPTYPE_INT64, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return FieldAccess<FieldDescriptor::CPPTYPE_UINT32, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return FieldAccess<FieldDescriptor::CPPTYPE_UINT64, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        return FieldAccess<FieldDescriptor::CPPTYPE_FLOAT, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        return FieldAccess<FieldDescriptor::CPPTYPE_DOUBLE, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return FieldAccess<FieldDescriptor::CPPTYPE_BOOL, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return FieldAccess<FieldDescriptor::CPPTYPE_ENUM, FieldKind::SCALAR>::get(field);
+
+    default:
+        assert(false);
+        return 0;
+    }
+}
+
+std::string tag_value(const ConstFieldRef &field) {
+    switch (field.type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+        return FieldAccess<FieldDescriptor::CPPTYPE_STRING, FieldKind::SCALAR>::get(field);
+
+    case FieldDescriptor::CPPTYPE_INT32:
+        return std::to_string(
+                FieldAccess<FieldDescriptor::CPPTYPE_INT32, FieldKind::SCALAR>::get(field));
+
+    case FieldDescriptor::CPPTYPE_INT64:
+        return std::to_string(
+                FieldAccess<FieldDescriptor::CPPTYPE_INT64, FieldKind::SCALAR>::get(field));
+
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return std::to_string(
+                FieldAccess<FieldDescriptor::CPPTYPE_UINT32, FieldKind::SCALAR>::get(field));
+
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return std::to_string(
+                FieldAccess<FieldDescriptor::CPPTYPE_UINT64, FieldKind::SCALAR>::get(field));
+
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return std::to_string(static_cast<int>(
+                    FieldAccess<FieldDescriptor::CPPTYPE_BOOL, FieldKind::SCALAR>::get(field)));
+
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return std::to_string(
+                FieldAccess<FieldDescriptor::CPPTYPE_ENUM, FieldKind::SCALAR>::get(field));
+
+    default:
+        assert(false);
+        return "";
+    }
+}
+
+const Message* lookup(RedisModuleCtx *ctx, RedisModuleString *key_name) {
+    auto key = open_key(ctx, key_name, KeyMode::READONLY);
+    if (RedisModule_KeyType(key.get()) != REDISMODULE_KEYTYPE_MODULE
+            || RedisModule_ModuleTypeGetType(key.get()) != RedisProtobuf::instance().type()) {
+        return nullptr;
+    }
+
+    return get_msg_by_key(key.get());
+}
+
+}
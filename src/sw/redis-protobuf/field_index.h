@@ -0,0 +1,332 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_FIELD_INDEX_H
+#define SEWENEW_REDISPROTOBUF_FIELD_INDEX_H
+
+#include "module_api.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <google/protobuf/message.h>
+#include "utils.h"
+#include "path.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Secondary indexes from the value of a non-repeated field to keys, whose messages
+// have the value, e.g. find keys of type Msg whose /sub/i is between 1 and 10.
+//
+// Indexes are created in the selected database, and only index keys of that database.
+// Redis doesn't tell us the key name when a message is loaded or freed, and the free
+// callback might be called in a background thread, e.g. FLUSHALL ASYNC. So indexes
+// never refer to messages, and they're maintained in the following way:
+// - Entries are keyed by key names, and a hit is verified by checking that the key
+//   still holds a message of the type, with the indexed value. Otherwise, the key is
+//   re-indexed. So keys deleted, renamed or moved by other commands are never returned.
+// - Keys opened for writing, i.e. modified by our commands, are marked dirty, and
+//   re-indexed before the next lookup.
+// - Keys written without our commands, e.g. RENAME, MOVE or RESTORE, are indexed by
+//   a background thread, which scans the database in batches. A scan starts when an
+//   index is created, when messages are loaded, and periodically. The thread holds
+//   the GIL only while processing a batch, so Redis is never blocked by a full scan.
+//
+// An index cannot be used until the first scan finishes.
+//
+// Key registries, i.e. keys of each type, are maintained in the same way. A registry
+// is created on first use, so that there's no overhead if it's never used.
+class FieldIndexes {
+public:
+    enum class Kind {
+        NUMERIC = 0,
+        TAG,
+        // Key registry of a type, which indexes no field.
+        REGISTRY,
+        NONE
+    };
+
+    // A numeric range, and an endpoint is excluded if it's exclusive.
+    struct Range {
+        double min;
+        bool min_exclusive;
+        double max;
+        bool max_exclusive;
+    };
+
+    FieldIndexes() = default;
+
+    FieldIndexes(const FieldIndexes &) = delete;
+    FieldIndexes& operator=(const FieldIndexes &) = delete;
+
+    FieldIndexes(FieldIndexes &&) = delete;
+    FieldIndexes& operator=(FieldIndexes &&) = delete;
+
+    ~FieldIndexes();
+
+    // Create an index on the field at *path* of messages of *type*, which is
+    // built by scanning the selected database in background.
+    // If kind is NONE, create a NUMERIC index for numeric field, and TAG index for others.
+    void create(RedisModuleCtx *ctx,
+            const std::string &name,
+            const Path &path,
+            Kind kind);
+
+    // Return false, if the index doesn't exist.
+    bool drop(RedisModuleCtx *ctx, const std::string &name);
+
+    // Throw Error, if the index doesn't exist.
+    Kind kind(RedisModuleCtx *ctx, const std::string &name) const;
+
+    // Return the number of indexed keys.
+    // Throw Error, if the index doesn't exist, or it's still being built.
+    long long size(RedisModuleCtx *ctx, const std::string &name) const;
+
+    // Unblock *bc* when the index is built or dropped.
+    void wait(RedisModuleCtx *ctx, const std::string &name, RedisModuleBlockedClient *bc);
+
+    // Return keys whose field values are in the range, in ascending order of values.
+    // Throw Error, if the index is still being built.
+    std::vector<std::string> find(RedisModuleCtx *ctx,
+            const std::string &name,
+            const Range &range,
+            long long offset,
+            long long count);
+
+    // Return keys whose field values equal to *tag*.
+    // Throw Error, if the index is still being built.
+    std::vector<std::string> find(RedisModuleCtx *ctx,
+            const std::string &name,
+            const std::string &tag,
+            long long offset,
+            long long count);
+
+    // Create the key registry of *type* on first use, and return whether it has been built.
+    bool registered(RedisModuleCtx *ctx, const std::string &type);
+
+    // Unblock *bc* when the key registry of *type* is built.
+    void wait_registry(RedisModuleCtx *ctx, const std::string &type, RedisModuleBlockedClient *bc);
+
+    // Visit at most *count* keys of *type*, which are greater than *after*, in
+    // lexicographical order, and return those still holding messages of *type*.
+    // *last* is set to the last visited key, or empty, if no more keys left.
+    // The key registry of *type* should have been built.
+    std::vector<std::string> keys(RedisModuleCtx *ctx,
+            const std::string &type,
+            const Optional<std::string> &after,
+            long long count,
+            Optional<std::string> &last);
+
+    // The key is opened for writing, and might be modified.
+    void touch(RedisModuleCtx *ctx, RedisModuleString *key_name);
+
+    // A message is loaded without key name. It's called in the main thread.
+    void loaded();
+
+private:
+    // The indexed value of a key.
+    struct Entry {
+        double number = 0;
+
+        std::string tag;
+    };
+
+    struct Index {
+        Path path;
+
+        Kind kind;
+
+        // key -> the indexed value. It's ordered, so that keys of a registry
+        // can be iterated with a cursor.
+        std::map<std::string, Entry> entries;
+
+        // Used by NUMERIC index, and points to keys in *entries*, so that keys
+        // are stored only once.
+        std::multimap<double, const std::string *> numbers;
+
+        // Used by TAG index.
+        std::unordered_map<std::string, std::unordered_set<const std::string *>> tags;
+
+        // Id of the scan, after which the index is built, or 0 if it has been built.
+        unsigned long long built_by_scan = 0;
+
+        // Clients waiting for the index to be built.
+        std::vector<RedisModuleBlockedClient *> waiters;
+    };
+
+    // Indexes and key registries of a database.
+    struct Db {
+        std::unordered_map<std::string, Index> indexes;
+
+        // type -> key registry of the type.
+        std::unordered_map<std::string, Index> registries;
+
+        std::unordered_set<std::string> dirty;
+
+        // Whether the background scan is running.
+        bool scanning = false;
+
+        // Cursor of the running scan.
+        std::string cursor;
+
+        // Id of the running scan, or the last one.
+        unsigned long long scan_id = 0;
+
+        // Another scan should start after the running one, since keys
+        // that have been scanned might be replaced.
+        bool rescan = false;
+
+        bool empty() const {
+            return indexes.empty() && registries.empty();
+        }
+    };
+
+    // State shared with the background thread. It's not a member of FieldIndexes,
+    // since the thread might outlive FieldIndexes, if it's waiting for the GIL on exit.
+    struct Worker {
+        std::mutex mtx;
+
+        std::condition_variable cv;
+
+        bool stop = false;
+
+        // Scans are requested.
+        bool wakeup = false;
+    };
+
+    // The selected database.
+    Db& _db(RedisModuleCtx *ctx);
+
+    // Return nullptr, if nothing is indexed in the selected database.
+    Db* _find_db(RedisModuleCtx *ctx);
+
+    const Db* _find_db(RedisModuleCtx *ctx) const;
+
+    // Throw Error, if the index doesn't exist.
+    Index& _index(Db *db, const std::string &name);
+
+    const Index& _index(const Db *db, const std::string &name) const;
+
+    // Throw Error, if the index doesn't exist, or it's still being built.
+    Index& _built_index(Db *db, const std::string &name);
+
+    // Apply *func* to each field index and registry of the database.
+    template <typename Func>
+    void _for_each(Db &db, Func &&func) {
+        for (auto &ele : db.indexes) {
+            func(ele.second);
+        }
+
+        for (auto &ele : db.registries) {
+            func(ele.second);
+        }
+    }
+
+    // Remove the database, if nothing is indexed.
+    void _shrink(RedisModuleCtx *ctx);
+
+    Kind _validate(const Path &path, Kind kind) const;
+
+    // Re-index dirty keys. The selected database should be *db*.
+    void _sync(RedisModuleCtx *ctx, Db &db);
+
+    void _reindex_dirty(RedisModuleCtx *ctx, Db &db);
+
+    // Request a background scan of the database, and return the id of the
+    // scan, after which all keys in the database have been scanned.
+    unsigned long long _request_scan(Db &db);
+
+    // Start the background thread if it's not running, and wake it up.
+    void _wake_up_worker();
+
+    // Entry of the background thread.
+    void _work(std::shared_ptr<Worker> worker);
+
+    // Scan a batch of keys of a database, whose scan has been requested, and
+    // re-index them. Return false, if no scan is requested.
+    // It's called with the GIL held.
+    bool _scan_batch(RedisModuleCtx *ctx);
+
+    // Request scans of all databases, so that keys written without our commands are indexed.
+    void _rescan_all();
+
+    // Mark indexes, which are built by the finished scan, as built, and unblock waiters.
+    void _finish_scan(Db &db);
+
+    void _unblock(Index &index);
+
+    // Scan a batch of keys from *cursor*, and apply *func* to each key name.
+    // Return the next cursor.
+    template <typename Func>
+    std::string _scan(RedisModuleCtx *ctx, const std::string &cursor, Func &&func) const;
+
+    void _reindex(RedisModuleCtx *ctx, Db &db, const std::string &key);
+
+    // Return false, if the message doesn't have the field to be indexed.
+    bool _entry(const Index &index, const gp::Message &msg, Entry &entry) const;
+
+    // Index the message of the key, and replace the old one if any.
+    void _add(Index &index, const std::string &key, const gp::Message &msg) const;
+
+    void _remove(Index &index, const std::string &key) const;
+
+    // Return false, if the key no longer holds the indexed value.
+    bool _verify(RedisModuleCtx *ctx, const Index &index, const std::string &key) const;
+
+    // Collect keys, which are verified, skipping the first *offset* ones, and stale keys.
+    // Return false, if enough keys are collected.
+    bool _collect(RedisModuleCtx *ctx,
+            const Index &index,
+            const std::string &key,
+            long long &offset,
+            long long count,
+            std::vector<std::string> &keys,
+            std::vector<std::string> &stale) const;
+
+    // Limit the number of dirty keys between lookups.
+    static const std::size_t MAX_DIRTY_KEYS = 1024;
+
+    // Keys are scanned in batches, and the GIL is released between batches.
+    static const long long SCAN_BATCH = 1000;
+
+    // Interval between periodic scans of databases.
+    static constexpr std::chrono::seconds RESCAN_INTERVAL{60};
+
+    // db -> indexes of the database.
+    std::unordered_map<int, Db> _dbs;
+
+    std::shared_ptr<Worker> _worker;
+
+    std::thread _worker_thread;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_FIELD_INDEX_H
@@ -0,0 +1,71 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "field_mask.h"
+#include <cassert>
+#include <google/protobuf/util/field_mask_util.h>
+#include "errors.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace field_mask {
+
+gp::FieldMask parse(const StringView &mask, const gp::Descriptor *desc) {
+    assert(desc != nullptr);
+
+    gp::FieldMask field_mask;
+    gp::util::FieldMaskUtil::FromString(gp::StringPiece(mask.data(), mask.size()),
+                                        &field_mask);
+
+    for (const auto &path : field_mask.paths()) {
+        if (!gp::util::FieldMaskUtil::GetFieldDescriptors(desc, path, nullptr)) {
+            throw Error("invalid field mask path: " + path);
+        }
+    }
+
+    return field_mask;
+}
+
+void project(const gp::Message &src, const gp::FieldMask &mask, gp::Message &dest) {
+    assert(src.GetDescriptor() == dest.GetDescriptor());
+
+    gp::util::FieldMaskUtil::MergeMessageTo(src,
+            mask,
+            gp::util::FieldMaskUtil::MergeOptions(),
+            &dest);
+}
+
+void merge(const gp::Message &src, const gp::FieldMask &mask, gp::Message &dest) {
+    assert(src.GetDescriptor() == dest.GetDescriptor());
+
+    gp::util::FieldMaskUtil::MergeOptions options;
+    options.set_replace_message_fields(true);
+    options.set_replace_repeated_fields(true);
+
+    gp::util::FieldMaskUtil::MergeMessageTo(src, mask, options, &dest);
+}
+
+}
+
+}
+
+}
+
+}
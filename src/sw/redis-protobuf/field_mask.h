@@ -0,0 +1,54 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_FIELD_MASK_H
+#define SEWENEW_REDISPROTOBUF_FIELD_MASK_H
+
+#include <google/protobuf/message.h>
+#include <google/protobuf/field_mask.pb.h>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Helpers for field masks, i.e. comma separated field paths, e.g. "a,b.c,d".
+// Sub fields are separated by '.', and names are field names in the proto definition.
+namespace field_mask {
+
+// Parse the mask, and validate its paths with the descriptor of the message.
+// Throw Error if any path doesn't exist.
+gp::FieldMask parse(const StringView &mask, const gp::Descriptor *desc);
+
+// Copy only the masked fields of *src* to *dest*, which should be empty.
+void project(const gp::Message &src, const gp::FieldMask &mask, gp::Message &dest);
+
+// Overwrite the masked fields of *dest* with those of *src*. Masked arrays and
+// sub messages are replaced instead of merged, and masked fields that are not
+// set in *src* are cleared.
+void merge(const gp::Message &src, const gp::FieldMask &mask, gp::Message &dest);
+
+}
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_FIELD_MASK_H
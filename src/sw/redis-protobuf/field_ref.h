@@ -17,16 +17,19 @@
 #ifndef SEWENEW_REDISPROTOBUF_FIELD_REF_H
 #define SEWENEW_REDISPROTOBUF_FIELD_REF_H
 
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <type_traits>
 #include <vector>
 #include <google/protobuf/message.h>
-#include <google/protobuf/map_field.h>
-#include <google/protobuf/map.h>
 #include "module_api.h"
 #include "utils.h"
 #include "path.h"
+#include "map_access.h"
+#include "repeated_access.h"
+#include "field_mask.h"
+#include "redis_protobuf.h"
 
 namespace sw {
 
@@ -41,6 +44,22 @@ class FieldRef {
 public:
     FieldRef(Msg *root_msg, const Path &path);
 
+    // Read-only view of a MutableFieldRef, so that writers can reply with
+    // the field, without resolving the path again.
+    template <typename Other,
+             typename std::enable_if<std::is_const<Msg>::value
+                 && std::is_same<const Other, Msg>::value, int>::type = 0>
+    FieldRef(const FieldRef<Other> &field) :
+        _root_msg(field._root_msg),
+        _msg(field._msg),
+        _field_desc(field._field_desc),
+        _arr_idx(field._arr_idx),
+        _slice_begin(field._slice_begin),
+        _slice_end(field._slice_end),
+        _map_key(field._map_key),
+        _map_value(field._map_value),
+        _missing(field._missing) {}
+
     gp::FieldDescriptor::CppType type() const {
         if (_field_desc == nullptr) {
             throw Error("invalid path: null field");
@@ -49,6 +68,15 @@ public:
         return _field_desc->cpp_type();
     }
 
+    // Type in the proto definition, e.g. sint32 or fixed32, which decides the wire format.
+    gp::FieldDescriptor::Type declared_type() const {
+        if (_field_desc == nullptr) {
+            throw Error("invalid path: null field");
+        }
+
+        return _field_desc->type();
+    }
+
     gp::FieldDescriptor::CppType map_value_type() const {
         const auto *val_desc = _mapped_value_desc();
         return val_desc->cpp_type();
@@ -66,6 +94,11 @@ public:
         return _arr_idx >= 0;
     }
 
+    // Whether it's a range of an array, e.g. /arr/[1:3].
+    bool is_array_slice() const {
+        return _slice_end >= 0;
+    }
+
     bool is_map() const {
         return _field_desc != nullptr && _field_desc->is_map();
     }
@@ -74,10 +107,44 @@ public:
         return bool(_map_key);
     }
 
+    // For ConstFieldRef, if the path refers to a non-existent map key or array
+    // element, it's marked as missing instead of throwing an exception, so
+    // that misses, which are quite common, can be replied cheaply. Callers
+    // should check it before reading the field. For MutableFieldRef, it
+    // throws, since we cannot write to a missing element.
+    bool missing() const {
+        return !_missing.empty();
+    }
+
+    // Why the field is missing.
+    const std::string& missing_reason() const {
+        return _missing;
+    }
+
+    // Whether the map element has been in the map. Setting a non-existent
+    // map element of MutableFieldRef inserts it.
+    bool map_element_exists() const {
+        assert(is_map_element());
+
+        return _map_value != nullptr
+            || map_access::find_value(*_msg, _field_desc, *_map_key) != nullptr;
+    }
+
     int size() const;
 
+    // Move the reference one level down, i.e. to the field, array element,
+    // or map value specified by *field*, which is a single path segment.
+    void descend(const std::string &field);
+
     FieldRef get_array_element(int idx) const;
 
+    // If *value* is specified, it should be the value of *key* in the map,
+    // and it saves a map lookup when getting the value.
+    FieldRef get_map_element(const gp::MapKey &key,
+            const gp::MapValueRef *value = nullptr) const;
+
+    const gp::Map<gp::MapKey, gp::MapValueRef>& get_map() const;
+
     auto get_map_range() const ->
         std::pair<gp::Map<gp::MapKey, gp::MapValueRef>::const_iterator,
             gp::Map<gp::MapKey, gp::MapValueRef>::const_iterator>;
@@ -167,106 +234,116 @@ public:
     }
 
     int32_t get_mapped_int32() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetInt32Value();
+        return _mapped_value().GetInt32Value();
     }
 
     int64_t get_mapped_int64() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetInt64Value();
+        return _mapped_value().GetInt64Value();
     }
 
     uint32_t get_mapped_uint32() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetUInt32Value();
+        return _mapped_value().GetUInt32Value();
     }
 
     uint64_t get_mapped_uint64() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetUInt64Value();
+        return _mapped_value().GetUInt64Value();
     }
 
     float get_mapped_float() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetFloatValue();
+        return _mapped_value().GetFloatValue();
     }
 
     double get_mapped_double() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetDoubleValue();
+        return _mapped_value().GetDoubleValue();
     }
 
     bool get_mapped_bool() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetBoolValue();
+        return _mapped_value().GetBoolValue();
     }
 
     int get_mapped_enum() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetEnumValue();
+        return _mapped_value().GetEnumValue();
     }
 
     std::string get_mapped_string() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetStringValue();
+        return _mapped_value().GetStringValue();
     }
 
     const gp::Message& get_mapped_msg() const {
-        const auto &val = _get_map_value_const(_msg, _field_desc, *_map_key);
-        return val.GetMessageValue();
+        return _mapped_value().GetMessageValue();
     }
 
     void set_mapped_int32(int32_t val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetInt32Value(val);
+        _mutable_mapped_value().SetInt32Value(val);
     }
 
     void set_mapped_int64(int64_t val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetInt64Value(val);
+        _mutable_mapped_value().SetInt64Value(val);
     }
 
     void set_mapped_uint32(uint32_t val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetUInt32Value(val);
+        _mutable_mapped_value().SetUInt32Value(val);
     }
 
     void set_mapped_uint64(uint64_t val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetUInt64Value(val);
+        _mutable_mapped_value().SetUInt64Value(val);
     }
 
     void set_mapped_float(float val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetFloatValue(val);
+        _mutable_mapped_value().SetFloatValue(val);
     }
 
     void set_mapped_double(double val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetDoubleValue(val);
+        _mutable_mapped_value().SetDoubleValue(val);
     }
 
     void set_mapped_bool(bool val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetBoolValue(val);
+        _mutable_mapped_value().SetBoolValue(val);
     }
 
     void set_mapped_enum(int val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetEnumValue(val);
+        _mutable_mapped_value().SetEnumValue(val);
     }
 
     void set_mapped_string(const std::string &val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        val_ref.SetStringValue(val);
+        _mutable_mapped_value().SetStringValue(val);
+    }
+
+    // Append to the string value in place, and return the new length.
+    std::size_t append_mapped_string(const std::string &val) {
+        auto value = _mutable_mapped_value();
+        map_access::append_string(value, val);
+
+        return value.GetStringValue().size();
     }
 
     void set_mapped_msg(const gp::Message &val) {
-        auto &val_ref = _get_map_value(_msg, _field_desc, *_map_key);
-        auto *msg = val_ref.MutableMessageValue();
+        auto *msg = _mutable_mapped_value().MutableMessageValue();
         msg->CopyFrom(val);
     }
 
+    // Get the underlying RepeatedField of a whole numeric array for bulk operations.
+    template <typename T>
+    const gp::RepeatedField<T>& repeated_field() const {
+        assert(is_array() && !is_array_element() && !is_map());
+
+        return repeated_access::repeated_field<T>(*_msg, _field_desc);
+    }
+
+    template <typename T>
+    gp::RepeatedField<T>& mutable_repeated_field() {
+        assert(is_array() && !is_array_element() && !is_map());
+
+        return repeated_access::mutable_repeated_field<T>(*_msg, _field_desc);
+    }
+
+    template <typename T>
+    gp::RepeatedPtrField<T>& mutable_repeated_ptr_field() {
+        assert(is_array() && !is_array_element() && !is_map());
+
+        return repeated_access::mutable_repeated_ptr_field<T>(*_msg, _field_desc);
+    }
+
     void set_int32(int32_t val);
     void set_int64(int64_t val);
     void set_uint32(uint32_t val);
@@ -304,9 +381,18 @@ public:
 
     void del();
 
+    // Delete elements in [begin, end) of the whole array, with a single block move.
+    void del_range(int begin, int end);
+
     void merge(const gp::Message &msg);
 
+    // Only merge the masked fields, see field_mask::merge for details.
+    void merge(const gp::Message &msg, const gp::FieldMask &mask);
+
 private:
+    template <typename Other>
+    friend class FieldRef;
+
     Msg* _get_sub_msg(Msg *msg, const gp::FieldDescriptor *field_desc, std::true_type) {
         return &(msg->GetReflection()->GetMessage(*msg, field_desc));
     }
@@ -343,78 +429,42 @@ private:
         return _get_sub_repeated_msg(msg, field_desc, idx, typename std::is_const<Msg>::type());
     }
 
-    class NotFoundError : public Error {
-    public:
-        NotFoundError() : Error("key not found") {}
-    };
+    // Get the value of the map element for reading, and the result is cached.
+    const gp::MapValueRef& _mapped_value() const {
+        assert(is_map_element());
 
-    const gp::MapValueRef& _get_map_value_const(Msg *msg,
-            const gp::FieldDescriptor *field_desc,
-            const gp::MapKey &key) const {
-        // The following is hacking, hacking, and hacking!!!
-        const auto *reflection =
-            static_cast<const gp::internal::GeneratedMessageReflection*>(msg->GetReflection());
-        const auto &map_base = reflection->GetRaw<gp::internal::MapFieldBase>(*msg, field_desc);
-        const auto &dynamic_map = static_cast<const gp::internal::DynamicMapField&>(map_base);
-        const auto &m = dynamic_map.GetMap();
-        auto iter = m.find(key);
-        if (iter == m.end()) {
-            throw NotFoundError();
+        if (_map_value == nullptr) {
+            _map_value = map_access::find_value(*_msg, _field_desc, *_map_key);
+            if (_map_value == nullptr) {
+                throw Error("key not found");
+            }
         }
 
-        return iter->second;
+        return *_map_value;
     }
 
-    gp::MapValueRef& _get_map_value(Msg *msg,
-            const gp::FieldDescriptor *field_desc,
-            const gp::MapKey &key) {
-        // The following is hacking, hacking, and hacking!!!
-        const auto *reflection =
-            static_cast<const gp::internal::GeneratedMessageReflection*>(msg->GetReflection());
-        auto *map_base = reflection->MutableRaw<gp::internal::MapFieldBase>(msg, field_desc);
-        auto *dynamic_map = static_cast<gp::internal::DynamicMapField*>(map_base);
-
-        // Ensure the value is initialized.
-        gp::MapValueRef val;
-        dynamic_map->InsertOrLookupMapValue(key, &val);
+    // Get the value of the map element for writing, and insert it, if it doesn't exist.
+    gp::MapValueRef _mutable_mapped_value() {
+        assert(is_map_element());
 
-        auto *m = dynamic_map->MutableMap();
-        auto iter = m->find(key);
-        assert(iter != m->end());
-
-        return iter->second;
+        return map_access::insert_or_lookup_value(*_msg, _field_desc, *_map_key);
     }
 
-    Msg* _get_map_msg(Msg *msg,
-            const gp::FieldDescriptor *field_desc,
-            const gp::MapKey &key) {
-        return _get_map_msg(msg, field_desc, key, typename std::is_const<Msg>::type());
-    }
-
-    Msg* _get_map_msg(Msg *msg,
-            const gp::FieldDescriptor *field_desc,
-            const gp::MapKey &key,
-            std::true_type) {
-        const auto &val = _get_map_value_const(msg, field_desc, key);
-        const auto *val_desc = _mapped_value_desc();
+    Msg* _get_map_msg() {
+        auto *val_desc = _mapped_value_desc();
         if (val_desc->cpp_type() != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
             throw Error("map value is not of message type");
         }
 
-        return &val.GetMessageValue();
+        return _get_map_msg(typename std::is_const<Msg>::type());
     }
 
-    Msg* _get_map_msg(Msg *msg,
-            const gp::FieldDescriptor *field_desc,
-            const gp::MapKey &key,
-            std::false_type) {
-        auto &val = _get_map_value(msg, field_desc, key);
-        auto *val_desc = _mapped_value_desc();
-        if (val_desc->cpp_type() != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
-            throw Error("map value is not of message type");
-        }
+    Msg* _get_map_msg(std::true_type) {
+        return &_mapped_value().GetMessageValue();
+    }
 
-        return val.MutableMessageValue();
+    Msg* _get_map_msg(std::false_type) {
+        return _mutable_mapped_value().MutableMessageValue();
     }
 
     const gp::FieldDescriptor* _mapped_value_desc() const {
@@ -431,8 +481,25 @@ private:
 
     void _validate_parameters(Msg *root_msg, const Path &path) const;
 
+    // Find field by name, or by tag number if *field* is of '#number' format.
+    const gp::FieldDescriptor* _find_field(const gp::Descriptor *desc,
+            const std::string &field) const;
+
+    // Select the field of _msg, and if *field* is of 'name[key]' format,
+    // also select the element of the array or map.
+    void _select_field(const std::string &field);
+
     void _parse_aggregate_field(const std::string &field);
 
+    // Find the array element with *predicate*, i.e. 'key_field=value'.
+    // Return -1, if no such element.
+    int _find_element(const std::string &predicate) const;
+
+    void _parse_array_index(const std::string &field);
+
+    // The field doesn't exist.
+    void _miss(std::string reason);
+
     Optional<gp::MapKey> _parse_map_key(const std::string &key) {
         return _parse_map_key_impl(key, typename std::is_const<Msg>::type());
     }
@@ -445,7 +512,22 @@ private:
         return _parse_map_key_impl(key);
     }
 
-    void _del_array_element();
+    void _parse_array_slice(const std::string &field);
+
+    // Convert a, possibly negative, slice boundary to an index in [0, size].
+    int _slice_boundary(const std::string &field, const std::string &boundary, int size) const;
+
+    void _del_array_range(int begin, int end);
+
+    // The sub-message to be merged to.
+    Msg* _merge_target();
+
+    template <typename T>
+    void _erase_range(gp::RepeatedField<T> &arr, int begin, int end) {
+        arr.erase(arr.begin() + begin, arr.begin() + end);
+    }
+
+    Msg *_root_msg = nullptr;
 
     Msg *_msg = nullptr;
 
@@ -453,7 +535,18 @@ private:
 
     int _arr_idx = -1;
 
+    // [_slice_begin, _slice_end) of the array, if it's an array slice.
+    int _slice_begin = 0;
+
+    int _slice_end = -1;
+
     Optional<gp::MapKey> _map_key;
+
+    // Cached value of the map element, so that we don't need to lookup the map again.
+    mutable const gp::MapValueRef *_map_value = nullptr;
+
+    // Non-empty, if the field is missing.
+    std::string _missing;
 };
 
 using ConstFieldRef = FieldRef<const gp::Message>;
@@ -466,64 +559,63 @@ FieldRef<Msg>::FieldRef(Msg *root_msg, const Path &path) {
     // Here we have to give _map_key a valid value.
     _map_key->SetBoolValue(false);
 
+    _root_msg = root_msg;
     _msg = root_msg;
 
-    const auto &fields = path.fields();
-    for (auto idx = 0U; idx != fields.size(); ++idx) {
-        const auto &field = fields[idx];
-
-        assert(!field.empty() && _msg != nullptr);
-
-        if (is_map_element()) {
-            assert(_field_desc != nullptr);
-            _msg = _get_map_msg(_msg, _field_desc, *_map_key);
-            _map_key.reset();
-            _map_key->SetBoolValue(false);
-            _field_desc = nullptr;
-        } else if (is_array_element()) {
-            assert(_field_desc != nullptr);
-            _msg = _get_sub_repeated_msg(_msg, _field_desc, _arr_idx);
-            _arr_idx = -1;
-            _field_desc = nullptr;
-        }
+    for (const auto &field : path.fields()) {
+        descend(field);
+    }
+}
 
-        if (_field_desc == nullptr) {
-            _field_desc = _msg->GetDescriptor()->FindFieldByName(field);
-            if (_field_desc == nullptr) {
-                throw Error("field not found: " + field);
+template <typename Msg>
+void FieldRef<Msg>::descend(const std::string &field) {
+    assert(!field.empty() && _msg != nullptr);
+
+    if (missing()) {
+        // Nothing to descend.
+        return;
+    }
+
+    if (is_array_slice()) {
+        throw Error("invalid path: array slice should be the last field");
+    }
+
+    if (is_map_element()) {
+        assert(_field_desc != nullptr);
+        _msg = _get_map_msg();
+        _map_key.reset();
+        _map_key->SetBoolValue(false);
+        _map_value = nullptr;
+        _field_desc = nullptr;
+    } else if (is_array_element()) {
+        assert(_field_desc != nullptr);
+        _msg = _get_sub_repeated_msg(_msg, _field_desc, _arr_idx);
+        _arr_idx = -1;
+        _field_desc = nullptr;
+    }
+
+    if (_field_desc == nullptr) {
+        _select_field(field);
+    } else {
+        if (_field_desc->is_map()) {
+            _map_key = _parse_map_key(field);
+            if (!_map_key) {
+                throw Error("invalid path: not valid map key");
+            }
+        } else if (_field_desc->is_repeated()) {
+            if (field.front() == '[') {
+                _parse_array_slice(field);
+                return;
             }
+
+            _parse_array_index(field);
         } else {
-            if (_field_desc->is_map()) {
-                _map_key = _parse_map_key(field);
-                if (!_map_key) {
-                    throw Error("invalid path: not valid map key");
-                }
-            } else if (_field_desc->is_repeated()) {
-                try {
-                    _arr_idx = std::stoi(field);
-                } catch (const std::exception &e) {
-                    throw Error("invalid array index: " + field);
-                }
-
-                auto size = _msg->GetReflection()->FieldSize(*_msg, _field_desc);
-                if (_arr_idx >= size) {
-                    throw Error("array index is out-of-range: " + field + " : " + std::to_string(size));
-                }
-
-                if (_arr_idx < 0) {
-                    throw Error("invalid path: array index should larger or equal to 0");
-                }
-            } else {
-                if (type() != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
-                    throw Error("invalid path: not a nested type: " + field);
-                }
-
-                _msg = _get_sub_msg(_msg, _field_desc);
-                _field_desc = _msg->GetDescriptor()->FindFieldByName(field);
-                if (_field_desc == nullptr) {
-                    throw Error("field not found: " + field);
-                }
+            if (type() != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
+                throw Error("invalid path: not a nested type: " + field);
             }
+
+            _msg = _get_sub_msg(_msg, _field_desc);
+            _select_field(field);
         }
     }
 }
@@ -532,8 +624,23 @@ template <typename Msg>
 FieldRef<Msg> FieldRef<Msg>::get_array_element(int idx) const {
     assert(is_array() && idx < size());
 
+    // If it's a slice, idx is relative to the beginning of the slice.
     FieldRef<Msg> element(*this);
-    element._arr_idx = idx;
+    element._arr_idx = _slice_begin + idx;
+    element._slice_begin = 0;
+    element._slice_end = -1;
+
+    return element;
+}
+
+template <typename Msg>
+FieldRef<Msg> FieldRef<Msg>::get_map_element(const gp::MapKey &key,
+        const gp::MapValueRef *value) const {
+    assert(is_map() && !is_map_element());
+
+    FieldRef<Msg> element(*this);
+    element._map_key = Optional<gp::MapKey>(key);
+    element._map_value = value;
 
     return element;
 }
@@ -542,18 +649,18 @@ template <typename Msg>
 auto FieldRef<Msg>::get_map_range() const ->
     std::pair<gp::Map<gp::MapKey, gp::MapValueRef>::const_iterator,
         gp::Map<gp::MapKey, gp::MapValueRef>::const_iterator> {
-    assert(is_map());
-
-    // The following is hacking, hacking, and hacking!!!
-    const auto *reflection =
-        static_cast<const gp::internal::GeneratedMessageReflection*>(_msg->GetReflection());
-    const auto &map_base = reflection->GetRaw<gp::internal::MapFieldBase>(*_msg, _field_desc);
-    const auto &dynamic_map = static_cast<const gp::internal::DynamicMapField&>(map_base);
-    const auto &m = dynamic_map.GetMap();
+    const auto &m = get_map();
 
     return {m.begin(), m.end()};
 }
 
+template <typename Msg>
+const gp::Map<gp::MapKey, gp::MapValueRef>& FieldRef<Msg>::get_map() const {
+    assert(is_map());
+
+    return map_access::get_map(*_msg, _field_desc);
+}
+
 template <typename Msg>
 std::string FieldRef<Msg>::msg_type() const {
     assert(_field_desc != nullptr);
@@ -585,6 +692,10 @@ int FieldRef<Msg>::size() const {
         throw Error("not an array or map");
     }
 
+    if (is_array_slice()) {
+        return _slice_end - _slice_begin;
+    }
+
     return _msg->GetReflection()->FieldSize(*_msg, _field_desc);
 }
 
@@ -597,6 +708,88 @@ void FieldRef<Msg>::_validate_parameters(Msg *root_msg, const Path &path) const
     }
 }
 
+template <typename Msg>
+const gp::FieldDescriptor* FieldRef<Msg>::_find_field(const gp::Descriptor *desc,
+        const std::string &field) const {
+    assert(desc != nullptr && !field.empty());
+
+    if (field.front() != '#') {
+        return desc->FindFieldByName(field);
+    }
+
+    auto number_opt = util::try_sv_to_int32(StringView(field.data() + 1, field.size() - 1));
+    if (!number_opt) {
+        throw Error("invalid field number: " + field);
+    }
+
+    auto number = *number_opt;
+
+    // Most messages number their fields as 1, 2, 3..., so try the field array
+    // with the tag number as index first, and avoid the hash lookup.
+    if (number > 0 && number <= desc->field_count()) {
+        const auto *field_desc = desc->field(number - 1);
+        if (field_desc->number() == number) {
+            return field_desc;
+        }
+    }
+
+    return desc->FindFieldByNumber(number);
+}
+
+template <typename Msg>
+void FieldRef<Msg>::_parse_array_slice(const std::string &field) {
+    assert(is_array() && !is_map() && !field.empty() && field.front() == '[');
+
+    auto pos = field.find(':');
+    if (field.back() != ']' || pos == std::string::npos) {
+        throw Error("invalid array slice: " + field);
+    }
+
+    auto size = _msg->GetReflection()->FieldSize(*_msg, _field_desc);
+
+    auto begin = field.substr(1, pos - 1);
+    auto end = field.substr(pos + 1, field.size() - pos - 2);
+
+    _slice_begin = begin.empty() ? 0 : _slice_boundary(field, begin, size);
+    _slice_end = end.empty() ? size : _slice_boundary(field, end, size);
+    if (_slice_end < _slice_begin) {
+        _slice_end = _slice_begin;
+    }
+}
+
+template <typename Msg>
+int FieldRef<Msg>::_slice_boundary(const std::string &field,
+        const std::string &boundary,
+        int size) const {
+    auto idx_opt = util::try_sv_to_int32(boundary);
+    if (!idx_opt) {
+        throw Error("invalid array slice: " + field);
+    }
+
+    auto idx = *idx_opt;
+
+    if (idx < 0) {
+        // Negative index counts from the end of the array.
+        idx += size;
+    }
+
+    return std::max(0, std::min(idx, size));
+}
+
+template <typename Msg>
+void FieldRef<Msg>::_select_field(const std::string &field) {
+    auto pos = field.find('[');
+    if (pos != std::string::npos && pos != 0 && field.back() == ']') {
+        _parse_aggregate_field(field);
+        return;
+    }
+
+    _field_desc = _find_field(_msg->GetDescriptor(), field);
+    if (_field_desc == nullptr) {
+        throw Error("field not found: " + field);
+    }
+}
+
 template <typename Msg>
 void FieldRef<Msg>::_parse_aggregate_field(const std::string &field) {
     assert(!field.empty() && field.back() == ']');
@@ -609,37 +802,99 @@ void FieldRef<Msg>::_parse_aggregate_field(const std::string &field) {
     auto name = field.substr(0, pos);
     auto key = field.substr(pos + 1, field.size() - pos - 2);
 
-    _field_desc = _msg->GetDescriptor()->FindFieldByName(name);
+    _field_desc = _find_field(_msg->GetDescriptor(), name);
     if (_field_desc == nullptr) {
         throw Error("invalid field: " + name);
     }
 
     if (is_map()) {
         _map_key = _parse_map_key(key);
+        if (!_map_key) {
+            throw Error("invalid path: not valid map key");
+        }
     } else if (is_array()) {
-        try {
-            _arr_idx = std::stoi(key);
-        } catch (const std::exception &e) {
-            throw Error("invalid array index: " + key);
+        if (key.find('=') == std::string::npos) {
+            _parse_array_index(key);
+            return;
         }
 
-        auto size = _msg->GetReflection()->FieldSize(*_msg, _field_desc);
-        if (_arr_idx >= size) {
-            throw Error("array index is out-of-range: " + key + " : " + std::to_string(size));
+        auto idx = _find_element(key);
+        if (idx < 0) {
+            _miss("element not found: " + key);
+        } else {
+            _arr_idx = idx;
         }
     } else {
         throw Error("not an array or map");
     }
 }
 
+template <typename Msg>
+int FieldRef<Msg>::_find_element(const std::string &predicate) const {
+    assert(is_array() && !is_map());
+
+    if (type() != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
+        throw Error("invalid path: predicate can only be applied to array of messages");
+    }
+
+    auto pos = predicate.find('=');
+    assert(pos != std::string::npos);
+
+    auto name = predicate.substr(0, pos);
+    const auto *key_field = name.empty() ?
+        nullptr : _find_field(_field_desc->message_type(), name);
+    if (key_field == nullptr || key_field->is_repeated()) {
+        throw Error("invalid predicate field: " + name);
+    }
+
+    auto val = StringView(predicate.data() + pos + 1, predicate.size() - pos - 1);
+    return RedisProtobuf::instance().element_index().find(*_root_msg,
+            *_msg,
+            _field_desc,
+            key_field,
+            val);
+}
+
+template <typename Msg>
+void FieldRef<Msg>::_parse_array_index(const std::string &field) {
+    assert(is_array() && !is_map());
+
+    auto idx = util::try_sv_to_int32(field);
+    if (!idx) {
+        throw Error("invalid array index: " + field);
+    }
+
+    if (*idx < 0) {
+        throw Error("invalid path: array index should larger or equal to 0");
+    }
+
+    auto size = _msg->GetReflection()->FieldSize(*_msg, _field_desc);
+    if (*idx >= size) {
+        _miss("array index is out-of-range: " + field + " : " + std::to_string(size));
+        return;
+    }
+
+    _arr_idx = *idx;
+}
+
+template <typename Msg>
+void FieldRef<Msg>::_miss(std::string reason) {
+    if (!std::is_const<Msg>::value) {
+        // We cannot write to a field that doesn't exist.
+        throw Error(reason);
+    }
+
+    _missing = std::move(reason);
+}
+
 template <typename Msg>
 Optional<gp::MapKey> FieldRef<Msg>::_parse_map_key_impl(const std::string &key, std::true_type) {
     auto map_key = _parse_map_key_impl(key);
 
-    try {
-        _get_map_value_const(_msg, _field_desc, *map_key);
-    } catch (const NotFoundError &e) {
-        throw MapKeyNotFoundError(key);
+    // Cache the value for later reading.
+    _map_value = map_access::find_value(*_msg, _field_desc, *map_key);
+    if (_map_value == nullptr) {
+        _miss("key not found: " + key);
     }
 
     return map_key;
@@ -855,7 +1110,21 @@ void FieldRef<Msg>::clear() {
         throw Error("cannot clear an array element");
     }
 
-    // TODO: map element.
+    if (is_array_slice()) {
+        throw Error("cannot clear an array slice");
+    }
+
+    if (is_map_element()) {
+        // Reset the value to default, i.e. remove it, and insert a default one.
+        // If the key doesn't exist, do nothing.
+        if (map_access::erase(*_msg, _field_desc, *_map_key)) {
+            _mutable_mapped_value();
+        }
+
+        _map_value = nullptr;
+
+        return;
+    }
 
     if (_field_desc == nullptr) {
         _msg->Clear();
@@ -867,39 +1136,138 @@ void FieldRef<Msg>::clear() {
 template <typename Msg>
 void FieldRef<Msg>::del() {
     if (is_array_element()) {
-        _del_array_element();
+        _del_array_range(_arr_idx, _arr_idx + 1);
+    } else if (is_array_slice()) {
+        _del_array_range(_slice_begin, _slice_end);
+    } else if (is_map_element()) {
+        // Single hash erase, instead of rebuilding the map.
+        map_access::erase(*_msg, _field_desc, *_map_key);
+        _map_value = nullptr;
     } else {
-        // TODO: support map
-        throw Error("can only delete array element");
+        throw Error("can only delete array element or map element");
     }
 }
 
 template <typename Msg>
 void FieldRef<Msg>::merge(const gp::Message &msg) {
+    auto *sub_msg = _merge_target();
+
+    assert(sub_msg->GetTypeName() == msg.GetTypeName());
+
+    sub_msg->MergeFrom(msg);
+}
+
+template <typename Msg>
+void FieldRef<Msg>::merge(const gp::Message &msg, const gp::FieldMask &mask) {
+    auto *sub_msg = _merge_target();
+
+    assert(sub_msg->GetTypeName() == msg.GetTypeName());
+
+    field_mask::merge(msg, mask, *sub_msg);
+}
+
+template <typename Msg>
+Msg* FieldRef<Msg>::_merge_target() {
     assert(_field_desc != nullptr);
 
+    if (is_array_slice()) {
+        throw Error("cannot merge to an array slice");
+    }
+
+    if (is_map_element()) {
+        return _get_map_msg();
+    }
+
     if (type() != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
         throw Error("not a message");
     }
 
-    auto sub_msg = _msg->GetReflection()->MutableMessage(_msg, _field_desc);
+    if (is_array_element()) {
+        return _get_sub_repeated_msg(_msg, _field_desc, _arr_idx);
+    }
 
-    assert(sub_msg->GetTypeName() == msg.GetTypeName());
+    if (is_array()) {
+        throw Error("cannot merge to an array or map");
+    }
 
-    sub_msg->MergeFrom(msg);
+    return _get_sub_msg(_msg, _field_desc);
+}
+
+template <typename Msg>
+void FieldRef<Msg>::del_range(int begin, int end) {
+    if (!is_array() || is_map() || is_array_element() || is_array_slice()) {
+        throw Error("not an array");
+    }
+
+    _del_array_range(begin, end);
 }
 
 template <typename Msg>
-void FieldRef<Msg>::_del_array_element() {
-    assert(is_array_element());
+void FieldRef<Msg>::_del_array_range(int begin, int end) {
+    assert(is_array() && 0 <= begin && begin <= end);
+    assert(end <= _msg->GetReflection()->FieldSize(*_msg, _field_desc));
 
-    const auto *reflection = _msg->GetReflection();
-    auto size = reflection->FieldSize(*_msg, _field_desc);
-    for (auto idx = _arr_idx; idx != size - 1; ++idx) {
-        reflection->SwapElements(_msg, _field_desc, idx, idx + 1);
+    if (begin == end) {
+        return;
     }
 
-    reflection->RemoveLast(_msg, _field_desc);
+    // Erase the range from the underlying repeated field, so that elements after
+    // the range are moved forward as a block, instead of swapping them one by one
+    // with reflection.
+    switch (_field_desc->cpp_type()) {
+    case gp::FieldDescriptor::CPPTYPE_INT32:
+        _erase_range(repeated_access::mutable_repeated_field<int32_t>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_INT64:
+        _erase_range(repeated_access::mutable_repeated_field<int64_t>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_UINT32:
+        _erase_range(repeated_access::mutable_repeated_field<uint32_t>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_UINT64:
+        _erase_range(repeated_access::mutable_repeated_field<uint64_t>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
+        _erase_range(repeated_access::mutable_repeated_field<double>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_FLOAT:
+        _erase_range(repeated_access::mutable_repeated_field<float>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_BOOL:
+        _erase_range(repeated_access::mutable_repeated_field<bool>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_ENUM:
+        _erase_range(repeated_access::mutable_repeated_field<int>(*_msg, _field_desc),
+                begin, end);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_STRING:
+        repeated_access::mutable_repeated_ptr_field<std::string>(*_msg, _field_desc)
+            .DeleteSubrange(begin, end - begin);
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_MESSAGE:
+        repeated_access::mutable_repeated_ptr_field<gp::Message>(*_msg, _field_desc)
+            .DeleteSubrange(begin, end - begin);
+        break;
+
+    default:
+        throw Error("unknown array type");
+    }
 }
 
 }
@@ -0,0 +1,610 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_FIELD_TYPE_H
+#define SEWENEW_REDISPROTOBUF_FIELD_TYPE_H
+
+#include <cassert>
+#include <string>
+#include "errors.h"
+#include "utils.h"
+#include "field_ref.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Compile-time helpers for dispatching on the C++ type of a field.
+//
+// Instead of switching on the CppType of the field, and the kind of container
+// (message, array or map) for every operation, commands write a handler
+// template once, i.e. Handler<CppType, FieldKind>, and look up the
+// instantiation for a field in a DispatchTable with a single indirect call.
+
+enum class FieldKind {
+    SCALAR = 0,
+    ARRAY_ELEMENT,
+    MAP_ELEMENT
+};
+
+template <typename Msg>
+FieldKind field_kind(const FieldRef<Msg> &field) {
+    // NOTE: map is also a repeated field, so check map first.
+    if (field.is_map_element()) {
+        return FieldKind::MAP_ELEMENT;
+    } else if (field.is_array_element()) {
+        return FieldKind::ARRAY_ELEMENT;
+    } else {
+        return FieldKind::SCALAR;
+    }
+}
+
+// Type of the value referred by the field, i.e. the mapped type for map element.
+template <typename Msg>
+gp::FieldDescriptor::CppType value_type(const FieldRef<Msg> &field) {
+    if (field.is_map_element()) {
+        return field.map_value_type();
+    } else {
+        return field.type();
+    }
+}
+
+// Conversions and FieldRef accessors of each CppType.
+template <gp::FieldDescriptor::CppType T>
+struct FieldType;
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_INT32> {
+    using Type = int32_t;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_int32(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_int32();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_int32();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_int32();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_int32(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_int32(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_int32(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_int32(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_INT64> {
+    using Type = int64_t;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_int64(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_int64();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_int64();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_int64();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_int64(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_int64(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_int64(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_int64(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_UINT32> {
+    using Type = uint32_t;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_uint32(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_uint32();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_uint32();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_uint32();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_uint32(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_uint32(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_uint32(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_uint32(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_UINT64> {
+    using Type = uint64_t;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_uint64(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_uint64();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_uint64();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_uint64();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_uint64(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_uint64(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_uint64(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_uint64(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_DOUBLE> {
+    using Type = double;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_double(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_double();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_double();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_double();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_double(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_double(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_double(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_double(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_FLOAT> {
+    using Type = float;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_float(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_float();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_float();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_float();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_float(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_float(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_float(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_float(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_BOOL> {
+    using Type = bool;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_bool(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_bool();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_bool();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_bool();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_bool(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_bool(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_bool(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_bool(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_ENUM> {
+    using Type = int;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_int32(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_enum();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_enum();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_enum();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_enum(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_enum(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_enum(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_enum(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_STRING> {
+    using Type = std::string;
+
+    template <typename Field>
+    static Type parse(const Field &, const StringView &sv) {
+        return util::sv_to_string(sv);
+    }
+
+    template <typename Field>
+    static Type get(const Field &field) {
+        return field.get_string();
+    }
+
+    template <typename Field>
+    static Type get_repeated(const Field &field) {
+        return field.get_repeated_string();
+    }
+
+    template <typename Field>
+    static Type get_mapped(const Field &field) {
+        return field.get_mapped_string();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_string(val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_string(val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_string(val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_string(val);
+    }
+};
+
+template <>
+struct FieldType<gp::FieldDescriptor::CPPTYPE_MESSAGE> {
+    using Type = MsgUPtr;
+
+    template <typename Field>
+    static Type parse(const Field &field, const StringView &sv) {
+        auto type = field.is_map_element() ? field.mapped_msg_type() : field.msg_type();
+        auto msg = RedisProtobuf::instance().proto_factory()->create(type, sv);
+        assert(msg);
+
+        return msg;
+    }
+
+    template <typename Field>
+    static const gp::Message& get(const Field &field) {
+        return field.get_msg();
+    }
+
+    template <typename Field>
+    static const gp::Message& get_repeated(const Field &field) {
+        return field.get_repeated_msg();
+    }
+
+    template <typename Field>
+    static const gp::Message& get_mapped(const Field &field) {
+        return field.get_mapped_msg();
+    }
+
+    static void set(MutableFieldRef &field, const Type &val) {
+        field.set_msg(*val);
+    }
+
+    static void set_repeated(MutableFieldRef &field, const Type &val) {
+        field.set_repeated_msg(*val);
+    }
+
+    static void set_mapped(MutableFieldRef &field, const Type &val) {
+        field.set_mapped_msg(*val);
+    }
+
+    static void add(MutableFieldRef &field, const Type &val) {
+        field.add_msg(*val);
+    }
+};
+
+// Read and write a field of the given kind.
+template <gp::FieldDescriptor::CppType T, FieldKind K>
+struct FieldAccess;
+
+template <gp::FieldDescriptor::CppType T>
+struct FieldAccess<T, FieldKind::SCALAR> {
+    template <typename Field>
+    static auto get(const Field &field) -> decltype(FieldType<T>::get(field)) {
+        return FieldType<T>::get(field);
+    }
+
+    static void set(MutableFieldRef &field, const typename FieldType<T>::Type &val) {
+        FieldType<T>::set(field, val);
+    }
+};
+
+template <gp::FieldDescriptor::CppType T>
+struct FieldAccess<T, FieldKind::ARRAY_ELEMENT> {
+    template <typename Field>
+    static auto get(const Field &field) -> decltype(FieldType<T>::get_repeated(field)) {
+        return FieldType<T>::get_repeated(field);
+    }
+
+    static void set(MutableFieldRef &field, const typename FieldType<T>::Type &val) {
+        FieldType<T>::set_repeated(field, val);
+    }
+};
+
+template <gp::FieldDescriptor::CppType T>
+struct FieldAccess<T, FieldKind::MAP_ELEMENT> {
+    template <typename Field>
+    static auto get(const Field &field) -> decltype(FieldType<T>::get_mapped(field)) {
+        return FieldType<T>::get_mapped(field);
+    }
+
+    static void set(MutableFieldRef &field, const typename FieldType<T>::Type &val) {
+        FieldType<T>::set_mapped(field, val);
+    }
+};
+
+// Table of Handler<T>::run indexed by CppType.
+template <template <gp::FieldDescriptor::CppType> class Handler, typename Func>
+class TypeDispatchTable {
+public:
+    TypeDispatchTable() {
+        _table[gp::FieldDescriptor::CPPTYPE_INT32] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_INT32>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_INT64] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_INT64>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_UINT32] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_UINT32>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_UINT64] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_UINT64>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_DOUBLE] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_DOUBLE>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_FLOAT] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_FLOAT>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_BOOL] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_BOOL>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_ENUM] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_ENUM>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_STRING] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_STRING>::run;
+        _table[gp::FieldDescriptor::CPPTYPE_MESSAGE] =
+            &Handler<gp::FieldDescriptor::CPPTYPE_MESSAGE>::run;
+    }
+
+    Func operator[](gp::FieldDescriptor::CppType type) const {
+        if (type <= 0 || type > gp::FieldDescriptor::MAX_CPPTYPE || _table[type] == nullptr) {
+            throw Error("unknown type");
+        }
+
+        return _table[type];
+    }
+
+private:
+    Func _table[gp::FieldDescriptor::MAX_CPPTYPE + 1] = {};
+};
+
+// Table of Handler<T, K>::run indexed by FieldKind and CppType.
+template <template <gp::FieldDescriptor::CppType, FieldKind> class Handler, typename Func>
+class DispatchTable {
+public:
+    Func get(FieldKind kind, gp::FieldDescriptor::CppType type) const {
+        switch (kind) {
+        case FieldKind::SCALAR:
+            return _scalar[type];
+
+        case FieldKind::ARRAY_ELEMENT:
+            return _array_element[type];
+
+        case FieldKind::MAP_ELEMENT:
+            return _map_element[type];
+
+        default:
+            throw Error("unknown field kind");
+        }
+    }
+
+    template <typename Msg>
+    Func get(const FieldRef<Msg> &field) const {
+        return get(field_kind(field), value_type(field));
+    }
+
+private:
+    template <FieldKind K>
+    struct Bind {
+        template <gp::FieldDescriptor::CppType T>
+        using Type = Handler<T, K>;
+    };
+
+    TypeDispatchTable<Bind<FieldKind::SCALAR>::template Type, Func> _scalar;
+
+    TypeDispatchTable<Bind<FieldKind::ARRAY_ELEMENT>::template Type, Func> _array_element;
+
+    TypeDispatchTable<Bind<FieldKind::MAP_ELEMENT>::template Type, Func> _map_element;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_FIELD_TYPE_H
@@ -0,0 +1,136 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "find_command.h"
+#include <limits>
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int FindCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(ctx, argv, argc);
+
+        auto &indexes = RedisProtobuf::instance().field_indexes();
+        auto keys = (args.kind == FieldIndexes::Kind::NUMERIC) ?
+            indexes.find(ctx, args.name, args.range, args.offset, args.count) :
+            indexes.find(ctx, args.name, args.tag, args.offset, args.count);
+
+        RedisModule_ReplyWithArray(ctx, keys.size());
+        for (const auto &key : keys) {
+            RedisModule_ReplyWithStringBuffer(ctx, key.data(), key.size());
+        }
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+FindCommand::Args FindCommand::_parse_args(RedisModuleCtx *ctx,
+        RedisModuleString **argv,
+        int argc) const {
+    assert(ctx != nullptr && argv != nullptr);
+
+    if (argc < 3) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.name = util::sv_to_string(argv[1]);
+    args.kind = RedisProtobuf::instance().field_indexes().kind(ctx, args.name);
+
+    auto pos = 2;
+    if (args.kind == FieldIndexes::Kind::NUMERIC) {
+        if (argc < 4) {
+            throw WrongArityError();
+        }
+
+        auto &range = args.range;
+        range.min_exclusive = _parse_endpoint(argv[2], range.min);
+        range.max_exclusive = _parse_endpoint(argv[3], range.max);
+        pos = 4;
+    } else {
+        args.tag = util::sv_to_string(argv[2]);
+        pos = 3;
+    }
+
+    _parse_limit(argv, argc, pos, args);
+
+    return args;
+}
+
+void FindCommand::_parse_limit(RedisModuleString **argv, int argc, int pos, Args &args) const {
+    if (pos == argc) {
+        return;
+    }
+
+    if (pos + 3 != argc || !util::str_case_equal(argv[pos], "LIMIT")) {
+        throw Error("syntax error");
+    }
+
+    try {
+        args.offset = util::sv_to_int64(argv[pos + 1]);
+        args.count = util::sv_to_int64(argv[pos + 2]);
+    } catch (const Error &) {
+        throw Error("invalid limit");
+    }
+
+    if (args.offset < 0) {
+        throw Error("invalid limit");
+    }
+}
+
+bool FindCommand::_parse_endpoint(const StringView &sv, double &val) const {
+    auto exclusive = false;
+    auto endpoint = sv;
+    if (sv.size() > 0 && *(sv.data()) == '(') {
+        exclusive = true;
+        endpoint = StringView(sv.data() + 1, sv.size() - 1);
+    }
+
+    if (util::str_case_equal(endpoint, "-inf")) {
+        val = -std::numeric_limits<double>::infinity();
+    } else if (util::str_case_equal(endpoint, "+inf")
+            || util::str_case_equal(endpoint, "inf")) {
+        val = std::numeric_limits<double>::infinity();
+    } else {
+        try {
+            val = util::sv_to_double(endpoint);
+        } catch (const Error &) {
+            throw Error("min or max is not a float");
+        }
+    }
+
+    return exclusive;
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,75 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_FIND_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_FIND_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include "utils.h"
+#include "field_index.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.FIND name min max [LIMIT offset count]
+//          PB.FIND name tag [LIMIT offset count]
+// return:  Array reply: keys whose indexed fields are in [min, max], in ascending
+//          order of the field values, if it's a NUMERIC index. Keys whose indexed
+//          fields equal to tag, if it's a TAG index. min and max can be -inf or +inf,
+//          and prefixed with '(' to exclude the endpoint.
+// error:   If the index doesn't exist, or min or max is invalid, return an error reply.
+class FindCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        std::string name;
+
+        FieldIndexes::Kind kind;
+
+        // Only for NUMERIC index.
+        FieldIndexes::Range range;
+
+        // Only for TAG index.
+        std::string tag;
+
+        long long offset = 0;
+
+        // Negative count means returning all keys after offset.
+        long long count = -1;
+    };
+
+    // Kind of the index is needed to parse the arguments.
+    Args _parse_args(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+    void _parse_limit(RedisModuleString **argv, int argc, int pos, Args &args) const;
+
+    // Parse a range endpoint, and return whether it's exclusive.
+    bool _parse_endpoint(const StringView &sv, double &val) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_FIND_COMMANDS_H
@@ -18,8 +18,7 @@
 #define SEWENEW_REDISPROTOBUF_GET_COMMANDS_H
 
 #include "module_api.h"
-#include "utils.h"
-#include "field_ref.h"
+#include "get_reply.h"
 
 namespace sw {
 
@@ -27,77 +26,24 @@ namespace redis {
 
 namespace pb {
 
-// command: PB.GET key [--FORMAT BINARY|JSON] type [path]
+// command: PB.GET key [--FORMAT BINARY|JSON] [--MASK mask] type [path [path ...]]
 // return:  If no path is specified, return the protobuf message of the key
 //          as a bulk string reply. If path is specified, return the value
 //          of the field specified with the path, and the reply type depends
-//          on the definition of the protobuf. If the key doesn't exist,
-//          return a nil reply.
+//          on the definition of the protobuf. If path has wildcards, i.e. '*',
+//          in array or map positions, or array slices, e.g. [1:3], followed
+//          by other fields, return an array reply of all matched values.
+//          The map key '*' is addressed with brackets, e.g. /m[*].
+//          If the path ends with an array slice, return an array reply of
+//          elements in the slice. If multiple paths are specified, return an
+//          array reply, and each item is the reply of the corresponding path,
+//          or an error reply if failed to get that path. If the key doesn't
+//          exist, return a nil reply. If --MASK is specified, e.g. "a,b.c", only
+//          the masked fields of the message, or the sub message at path, are returned.
 // error:   If the path doesn't exist, or type mismatch return an error reply.
 class GetCommand {
 public:
     int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
-
-private:
-    struct Args {
-        RedisModuleString *key_name;
-        
-        enum class Format {
-            BINARY = 0,
-            JSON,
-            NONE
-        };
-
-        Format format = Format::NONE;
-
-        Path path;
-    };
-
-    Args _parse_args(RedisModuleString **argv, int argc) const;
-
-    int _parse_opts(RedisModuleString **argv, int argc, Args &args) const;
-
-    Args::Format _parse_format(const StringView &format) const;
-
-    void _reply_with_nil(RedisModuleCtx *ctx) const;
-
-    void _reply_with_msg(RedisModuleCtx *ctx,
-            gp::Message &msg,
-            const Args &args) const;
-
-    void _get_scalar_field(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format) const;
-
-    void _get_array_element(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format) const;
-
-    void _get_array(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format) const;
-
-    void _get_map_element(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format) const;
-
-    void _get_map(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format) const;
-
-    void _get_map_kv(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format,
-            const gp::MapKey &key,
-            const gp::MapValueRef &value) const;
-
-    void _get_msg(RedisModuleCtx *ctx,
-            const gp::Message &msg,
-            Args::Format format) const;
-
-    void _get_field(RedisModuleCtx *ctx,
-            const ConstFieldRef &field,
-            Args::Format format) const;
 };
 
 }
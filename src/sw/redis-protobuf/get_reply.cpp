@@ -0,0 +1,604 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "get_reply.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "field_type.h"
+#include "field_mask.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace get_reply {
+
+namespace {
+
+template <gp::FieldDescriptor::CppType T, FieldKind K>
+struct ReplyHandler {
+    static void run(RedisModuleCtx *ctx, const ConstFieldRef &field, GetArgs::Format format) {
+        reply_with_value(ctx, FieldAccess<T, K>::get(field), format);
+    }
+};
+
+GetArgs::Format parse_format(const StringView &format);
+
+void get_msg(RedisModuleCtx *ctx, const gp::Message &msg, GetArgs::Format format);
+
+// Get only the masked fields of the message, or the sub message at path.
+void get_masked_msg(RedisModuleCtx *ctx, const gp::Message &msg, const GetArgs &args);
+
+void get_field(RedisModuleCtx *ctx, const ConstFieldRef &field, GetArgs::Format format);
+
+void get_array(RedisModuleCtx *ctx, const ConstFieldRef &field, GetArgs::Format format);
+
+void get_map(RedisModuleCtx *ctx, const ConstFieldRef &field, GetArgs::Format format);
+
+void get_projection(RedisModuleCtx *ctx,
+        const gp::Message &msg,
+        const Path &path,
+        GetArgs::Format format);
+
+// Reply with values of fields matching fields[idx...], and return the number of replies.
+long project(RedisModuleCtx *ctx,
+        ConstFieldRef field,
+        const std::vector<std::string> &fields,
+        std::size_t idx,
+        GetArgs::Format format);
+
+long project_elements(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        const std::vector<std::string> &fields,
+        std::size_t idx,
+        GetArgs::Format format);
+
+long project_element(RedisModuleCtx *ctx,
+        const ConstFieldRef &element,
+        const std::vector<std::string> &fields,
+        std::size_t idx,
+        GetArgs::Format format);
+
+bool is_wildcard(const std::string &field) {
+    return field == "*";
+}
+
+bool is_slice(const std::string &field) {
+    return !field.empty() && field.front() == '[';
+}
+
+// Whether the path might match more than one field, i.e. it has wildcards,
+// or array slices which are not the last field.
+bool is_projection(const Path &path);
+
+void validate_wildcard(const ConstFieldRef &field);
+
+}
+
+GetArgs parse_args(RedisModuleString **argv, int argc) {
+    assert(argv != nullptr);
+
+    if (argc < 3) {
+        throw WrongArityError();
+    }
+
+    GetArgs args;
+    args.key_name = argv[1];
+
+    auto pos = parse_opts(argv, argc, args);
+    if (pos >= argc) {
+        throw WrongArityError();
+    }
+
+    if (pos + 1 == argc) {
+        args.path = Path(argv[pos]);
+    } else if (pos + 2 == argc) {
+        args.path = Path(argv[pos], argv[pos + 1]);
+    } else {
+        // Multiple paths.
+        args.path = Path(argv[pos]);
+        args.paths.reserve(argc - pos - 1);
+        for (auto idx = pos + 1; idx != argc; ++idx) {
+            args.paths.emplace_back(argv[pos], argv[idx]);
+        }
+    }
+
+    return args;
+}
+
+int parse_opts(RedisModuleString **argv, int argc, GetArgs &args, int pos) {
+    auto idx = pos;
+    while (idx < argc) {
+        auto opt = StringView(argv[idx]);
+        if (util::str_case_equal(opt, "--FORMAT")) {
+            if (idx + 1 >= argc) {
+                throw Error("syntax error");
+            }
+
+            ++idx;
+
+            args.format = parse_format(argv[idx]);
+        } else if (util::str_case_equal(opt, "--MASK")) {
+            if (idx + 1 >= argc) {
+                throw Error("syntax error");
+            }
+
+            ++idx;
+
+            auto mask = StringView(argv[idx]);
+            args.mask = std::string(mask.data(), mask.size());
+            args.masked = true;
+        } else {
+            // Finish parsing options.
+            break;
+        }
+
+        ++idx;
+    }
+
+    return idx;
+}
+
+void validate_format(gp::FieldDescriptor::CppType type, GetArgs::Format format) {
+    if (type == gp::FieldDescriptor::CPPTYPE_MESSAGE && format == GetArgs::Format::NONE) {
+        throw Error("option --FORMAT not specified");
+    }
+}
+
+void reply_with_key(RedisModuleCtx *ctx, const GetArgs &args) {
+    auto key = api::open_key(ctx, args.key_name, api::KeyMode::READONLY);
+    if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
+        reply_with_nil(ctx);
+    } else {
+        auto *msg = api::get_msg_by_key(key.get());
+        assert(msg != nullptr);
+
+        reply_with_msg(ctx, *msg, args);
+    }
+}
+
+void reply_with_nil(RedisModuleCtx *ctx) {
+    RedisModule_ReplyWithNull(ctx);
+}
+
+void reply_with_msg(RedisModuleCtx *ctx,
+        gp::Message &msg,
+        const GetArgs &args) {
+    const auto &path = args.path;
+    if (msg.GetTypeName() != path.type()) {
+        throw Error("type mismatch");
+    }
+
+    if (args.masked) {
+        if (!args.paths.empty() || is_projection(path)) {
+            throw Error("--MASK only works with a single path");
+        }
+
+        return get_masked_msg(ctx, msg, args);
+    }
+
+    if (!args.paths.empty()) {
+        return reply_with_fields(ctx, msg, args);
+    }
+
+    if (path.empty()) {
+        // Get the whole message.
+        return get_msg(ctx, msg, args.format);
+    }
+
+    if (is_projection(path)) {
+        return get_projection(ctx, msg, path, args.format);
+    }
+
+    // Get field.
+    get_field(ctx, ConstFieldRef(&msg, path), args.format);
+}
+
+void reply_with_fields(RedisModuleCtx *ctx,
+        const gp::Message &msg,
+        const GetArgs &args) {
+    RedisModule_ReplyWithArray(ctx, args.paths.size());
+
+    // prefixes[i] is the reference after walking the first i fields of the last path,
+    // so that prefixes shared with the last path are only resolved once.
+    std::vector<ConstFieldRef> prefixes;
+    prefixes.emplace_back(&msg, args.path);
+
+    const std::vector<std::string> *last_fields = nullptr;
+    for (const auto &path : args.paths) {
+        try {
+            if (is_projection(path)) {
+                get_projection(ctx, msg, path, args.format);
+                continue;
+            }
+
+            const auto &fields = path.fields();
+
+            auto common = 0U;
+            if (last_fields != nullptr) {
+                while (common != fields.size()
+                        && common + 1 < prefixes.size()
+                        && fields[common] == (*last_fields)[common]) {
+                    ++common;
+                }
+            }
+
+            prefixes.erase(prefixes.begin() + common + 1, prefixes.end());
+            last_fields = &fields;
+
+            for (auto idx = common; idx != fields.size(); ++idx) {
+                auto field = prefixes.back();
+                field.descend(fields[idx]);
+                prefixes.push_back(field);
+            }
+
+            get_field(ctx, prefixes.back(), args.format);
+        } catch (const Error &e) {
+            api::reply_with_error(ctx, e);
+        }
+    }
+}
+
+void reply_with_value(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        GetArgs::Format format) {
+    using Func = void (*)(RedisModuleCtx *, const ConstFieldRef &, GetArgs::Format);
+
+    static const DispatchTable<ReplyHandler, Func> table;
+
+    table.get(field)(ctx, field, format);
+}
+
+void reply_with_map_kv(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        GetArgs::Format format,
+        const gp::MapKey &key,
+        const gp::MapValueRef &value) {
+    RedisModule_ReplyWithArray(ctx, 2);
+
+    // Reply with key.
+    switch (key.type()) {
+    case gp::FieldDescriptor::CPPTYPE_INT32: {
+        auto val = key.GetInt32Value();
+        RedisModule_ReplyWithLongLong(ctx, val);
+        break;
+    }
+    case gp::FieldDescriptor::CPPTYPE_INT64: {
+        auto val = key.GetInt64Value();
+        RedisModule_ReplyWithLongLong(ctx, val);
+        break;
+    }
+    case gp::FieldDescriptor::CPPTYPE_UINT32: {
+        auto val = key.GetUInt32Value();
+        RedisModule_ReplyWithLongLong(ctx, val);
+        break;
+    }
+    case gp::FieldDescriptor::CPPTYPE_UINT64: {
+        auto val = key.GetUInt64Value();
+        RedisModule_ReplyWithLongLong(ctx, val);
+        break;
+    }
+    case gp::FieldDescriptor::CPPTYPE_BOOL: {
+        auto val = key.GetBoolValue();
+        RedisModule_ReplyWithLongLong(ctx, val);
+        break;
+    }
+    case gp::FieldDescriptor::CPPTYPE_STRING: {
+        auto val = key.GetStringValue();
+        RedisModule_ReplyWithStringBuffer(ctx, val.data(), val.size());
+        break;
+    }
+    default:
+        assert(false);
+    }
+
+    // Reply with value.
+    reply_with_value(ctx, field.get_map_element(key, &value), format);
+}
+
+void reply_with_value(RedisModuleCtx *ctx, double val, GetArgs::Format) {
+    auto str = std::to_string(val);
+    RedisModule_ReplyWithSimpleString(ctx, str.data());
+}
+
+void reply_with_value(RedisModuleCtx *ctx, float val, GetArgs::Format) {
+    auto str = std::to_string(val);
+    RedisModule_ReplyWithSimpleString(ctx, str.data());
+}
+
+void reply_with_value(RedisModuleCtx *ctx,
+        const std::string &val,
+        GetArgs::Format) {
+    RedisModule_ReplyWithStringBuffer(ctx, val.data(), val.size());
+}
+
+void reply_with_value(RedisModuleCtx *ctx,
+        const gp::Message &msg,
+        GetArgs::Format format) {
+    get_msg(ctx, msg, format);
+}
+
+namespace {
+
+GetArgs::Format parse_format(const StringView &format) {
+    if (util::str_case_equal(format, "BINARY")) {
+        return GetArgs::Format::BINARY;
+    } else if (util::str_case_equal(format, "JSON")) {
+        return GetArgs::Format::JSON;
+    } else {
+        throw Error("unknown format");
+    }
+}
+
+void get_msg(RedisModuleCtx *ctx,
+        const gp::Message &msg,
+        GetArgs::Format format) {
+    std::string result;
+    switch (format) {
+    case GetArgs::Format::BINARY:
+        if (!msg.SerializeToString(&result)) {
+            throw Error("failed to serialize message to binary string");
+        }
+        break;
+
+    case GetArgs::Format::JSON:
+        result = util::msg_to_json(msg);
+        break;
+
+    case GetArgs::Format::NONE:
+        throw Error("option --FORMAT not specified");
+        break;
+
+    default:
+        assert(false);
+    }
+
+    RedisModule_ReplyWithStringBuffer(ctx, result.data(), result.size());
+}
+
+void get_masked_msg(RedisModuleCtx *ctx,
+        const gp::Message &msg,
+        const GetArgs &args) {
+    const auto *target = &msg;
+
+    const auto &path = args.path;
+    if (!path.empty()) {
+        ConstFieldRef field(&msg, path);
+        if (field.missing()) {
+            throw Error(field.missing_reason());
+        }
+
+        // NOTE: map is also a repeated field, so check map first.
+        auto is_aggregate = field.is_map() ?
+            !field.is_map_element() : field.is_array() && !field.is_array_element();
+        if (is_aggregate || value_type(field) != gp::FieldDescriptor::CPPTYPE_MESSAGE) {
+            throw Error("--MASK only works with message");
+        }
+
+        switch (field_kind(field)) {
+        case FieldKind::SCALAR:
+            target = &FieldAccess<gp::FieldDescriptor::CPPTYPE_MESSAGE,
+                                    FieldKind::SCALAR>::get(field);
+            break;
+
+        case FieldKind::ARRAY_ELEMENT:
+            target = &FieldAccess<gp::FieldDescriptor::CPPTYPE_MESSAGE,
+                                    FieldKind::ARRAY_ELEMENT>::get(field);
+            break;
+
+        case FieldKind::MAP_ELEMENT:
+            target = &FieldAccess<gp::FieldDescriptor::CPPTYPE_MESSAGE,
+                                    FieldKind::MAP_ELEMENT>::get(field);
+            break;
+
+        default:
+            assert(false);
+        }
+    }
+
+    auto mask = field_mask::parse(StringView(args.mask), target->GetDescriptor());
+
+    // Only copy the masked fields, instead of the whole message.
+    MsgUPtr projection(target->New());
+    field_mask::project(*target, mask, *projection);
+
+    get_msg(ctx, *projection, args.format);
+}
+
+void get_field(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        GetArgs::Format format) {
+    if (field.missing()) {
+        // Reply without throwing, since misses are common.
+        api::reply_with_error(ctx, Error(field.missing_reason()));
+        return;
+    }
+
+    if (field.is_map() && !field.is_map_element()) {
+        get_map(ctx, field, format);
+    } else if (field.is_array() && !field.is_array_element()) {
+        get_array(ctx, field, format);
+    } else {
+        reply_with_value(ctx, field, format);
+    }
+}
+
+void get_array(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        GetArgs::Format format) {
+    validate_format(field.type(), format);
+
+    auto arr_size = field.size();
+
+    RedisModule_ReplyWithArray(ctx, arr_size);
+
+    // Array elements always exist, and the format has been validated,
+    // so there's no need to catch errors for each element.
+    for (auto idx = 0; idx != arr_size; ++idx) {
+        get_field(ctx, field.get_array_element(idx), format);
+    }
+}
+
+void get_map(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        GetArgs::Format format) {
+    validate_format(field.map_value_type(), format);
+
+    auto arr_size = field.size();
+
+    RedisModule_ReplyWithArray(ctx, arr_size);
+
+    auto range = field.get_map_range();
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        reply_with_map_kv(ctx, field, format, iter->first, iter->second);
+    }
+}
+
+void get_projection(RedisModuleCtx *ctx,
+        const gp::Message &msg,
+        const Path &path,
+        GetArgs::Format format) {
+    const auto &fields = path.fields();
+
+    // Resolve the prefix before the first wildcard or slice, so that an invalid
+    // path is replied with an error, instead of an array of errors.
+    ConstFieldRef field(&msg, Path(path.type()));
+    auto idx = 0U;
+    for (; idx != fields.size(); ++idx) {
+        const auto &name = fields[idx];
+        if (is_wildcard(name)) {
+            validate_wildcard(field);
+            break;
+        }
+
+        field.descend(name);
+
+        if (field.missing() || (field.is_array_slice() && idx + 1 != fields.size())) {
+            break;
+        }
+    }
+
+    if (idx == fields.size() || field.missing()) {
+        // Nothing to expand.
+        return get_field(ctx, field, format);
+    }
+
+    RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+
+    auto len = project_elements(ctx, field, fields, idx + 1, format);
+
+    RedisModule_ReplySetArrayLength(ctx, len);
+}
+
+long project(RedisModuleCtx *ctx,
+        ConstFieldRef field,
+        const std::vector<std::string> &fields,
+        std::size_t idx,
+        GetArgs::Format format) {
+    for (; idx != fields.size(); ++idx) {
+        const auto &name = fields[idx];
+        if (is_wildcard(name)) {
+            validate_wildcard(field);
+
+            return project_elements(ctx, field, fields, idx + 1, format);
+        }
+
+        field.descend(name);
+
+        if (field.missing()) {
+            break;
+        }
+
+        if (field.is_array_slice() && idx + 1 != fields.size()) {
+            return project_elements(ctx, field, fields, idx + 1, format);
+        }
+    }
+
+    get_field(ctx, field, format);
+
+    return 1;
+}
+
+long project_elements(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        const std::vector<std::string> &fields,
+        std::size_t idx,
+        GetArgs::Format format) {
+    long len = 0;
+    if (field.is_map()) {
+        auto range = field.get_map_range();
+        for (auto iter = range.first; iter != range.second; ++iter) {
+            auto element = field.get_map_element(iter->first, &(iter->second));
+            len += project_element(ctx, element, fields, idx, format);
+        }
+    } else {
+        auto arr_size = field.size();
+        for (auto arr_idx = 0; arr_idx != arr_size; ++arr_idx) {
+            len += project_element(ctx, field.get_array_element(arr_idx), fields, idx, format);
+        }
+    }
+
+    return len;
+}
+
+long project_element(RedisModuleCtx *ctx,
+        const ConstFieldRef &element,
+        const std::vector<std::string> &fields,
+        std::size_t idx,
+        GetArgs::Format format) {
+    // Nothing has been replied, if an error is thrown, so that we can reply
+    // the error in place of the element.
+    try {
+        return project(ctx, element, fields, idx, format);
+    } catch (const Error &e) {
+        api::reply_with_error(ctx, e);
+
+        return 1;
+    }
+}
+
+bool is_projection(const Path &path) {
+    const auto &fields = path.fields();
+    for (auto idx = 0U; idx != fields.size(); ++idx) {
+        const auto &field = fields[idx];
+        if (is_wildcard(field) || (idx + 1 != fields.size() && is_slice(field))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void validate_wildcard(const ConstFieldRef &field) {
+    // NOTE: map is also a repeated field, so check map first.
+    auto is_aggregate = field.is_map() ?
+        !field.is_map_element() : field.is_array() && !field.is_array_element();
+    if (!is_aggregate) {
+        throw Error("invalid path: wildcard can only be applied to array or map");
+    }
+}
+
+}
+
+}
+
+}
+
+}
+
+}
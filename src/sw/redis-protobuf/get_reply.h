@@ -0,0 +1,115 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_GET_REPLY_H
+#define SEWENEW_REDISPROTOBUF_GET_REPLY_H
+
+#include "module_api.h"
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "utils.h"
+#include "path.h"
+#include "field_ref.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Arguments of PB.GET. Commands replying with messages or fields in the same
+// way as PB.GET, e.g. PB.MGET and PB.SCAN, share the options and paths.
+struct GetArgs {
+    RedisModuleString *key_name = nullptr;
+
+    enum class Format {
+        BINARY = 0,
+        JSON,
+        NONE
+    };
+
+    Format format = Format::NONE;
+
+    Path path;
+
+    // Non-empty, only if more than one path are specified.
+    std::vector<Path> paths;
+
+    // Comma separated field paths, only if masked is true. Own the mask,
+    // since args might outlive argv, e.g. prepared by PB.PREPARE.
+    std::string mask;
+
+    bool masked = false;
+};
+
+// Helpers to parse arguments of PB.GET, and reply with messages or fields.
+namespace get_reply {
+
+// Parse arguments of PB.GET, i.e. key [options] type [path [path ...]].
+GetArgs parse_args(RedisModuleString **argv, int argc);
+
+// Parse options starting from argv[pos], and return the position of the
+// first non-option argument.
+int parse_opts(RedisModuleString **argv, int argc, GetArgs &args, int pos = 2);
+
+// Message values cannot be replied without a format.
+void validate_format(gp::FieldDescriptor::CppType type, GetArgs::Format format);
+
+// Reply with the message saved in args.key_name, or nil if the key doesn't exist.
+void reply_with_key(RedisModuleCtx *ctx, const GetArgs &args);
+
+void reply_with_nil(RedisModuleCtx *ctx);
+
+void reply_with_msg(RedisModuleCtx *ctx, gp::Message &msg, const GetArgs &args);
+
+// Reply with an array of fields at args.paths, and errors are replied in place.
+void reply_with_fields(RedisModuleCtx *ctx, const gp::Message &msg, const GetArgs &args);
+
+// Reply with the value of a non-aggregate field, an array element or a map element.
+void reply_with_value(RedisModuleCtx *ctx, const ConstFieldRef &field, GetArgs::Format format);
+
+// Reply with a key-value pair of the map.
+void reply_with_map_kv(RedisModuleCtx *ctx,
+        const ConstFieldRef &field,
+        GetArgs::Format format,
+        const gp::MapKey &key,
+        const gp::MapValueRef &value);
+
+// Integers, enum and bool.
+template <typename T,
+         typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+void reply_with_value(RedisModuleCtx *ctx, T val, GetArgs::Format) {
+    RedisModule_ReplyWithLongLong(ctx, val);
+}
+
+void reply_with_value(RedisModuleCtx *ctx, double val, GetArgs::Format format);
+
+void reply_with_value(RedisModuleCtx *ctx, float val, GetArgs::Format format);
+
+void reply_with_value(RedisModuleCtx *ctx, const std::string &val, GetArgs::Format format);
+
+void reply_with_value(RedisModuleCtx *ctx, const gp::Message &msg, GetArgs::Format format);
+
+}
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_GET_REPLY_H
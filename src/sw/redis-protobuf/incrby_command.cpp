@@ -0,0 +1,283 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "incrby_command.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <type_traits>
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "field_type.h"
+
+namespace {
+
+using sw::redis::pb::gp::FieldDescriptor;
+using sw::redis::pb::Error;
+using sw::redis::pb::FieldAccess;
+using sw::redis::pb::FieldKind;
+using sw::redis::pb::FieldType;
+using sw::redis::pb::MutableFieldRef;
+using sw::redis::pb::StringView;
+
+template <FieldDescriptor::CppType T>
+using IsInteger = std::integral_constant<bool,
+      T == FieldDescriptor::CPPTYPE_INT32 || T == FieldDescriptor::CPPTYPE_INT64
+      || T == FieldDescriptor::CPPTYPE_UINT32 || T == FieldDescriptor::CPPTYPE_UINT64>;
+
+template <FieldDescriptor::CppType T>
+using IsFloat = std::integral_constant<bool,
+      T == FieldDescriptor::CPPTYPE_DOUBLE || T == FieldDescriptor::CPPTYPE_FLOAT>;
+
+template <typename T,
+         typename std::enable_if<std::is_signed<T>::value, int>::type = 0>
+T checked_add(T val, int64_t increment) {
+    if ((increment > 0 && val > std::numeric_limits<T>::max() - increment)
+            || (increment < 0 && val < std::numeric_limits<T>::min() - increment)) {
+        throw Error("increment or decrement would overflow");
+    }
+
+    return static_cast<T>(val + increment);
+}
+
+template <typename T,
+         typename std::enable_if<std::is_unsigned<T>::value, int>::type = 0>
+T checked_add(T val, int64_t increment) {
+    if (increment >= 0) {
+        auto inc = static_cast<uint64_t>(increment);
+        if (inc > std::numeric_limits<T>::max() || val > std::numeric_limits<T>::max() - inc) {
+            throw Error("increment or decrement would overflow");
+        }
+
+        return static_cast<T>(val + inc);
+    } else {
+        // Avoid overflow when negating INT64_MIN.
+        auto dec = static_cast<uint64_t>(-(increment + 1)) + 1;
+        if (val < dec) {
+            throw Error("increment or decrement would overflow");
+        }
+
+        return static_cast<T>(val - dec);
+    }
+}
+
+template <typename T>
+std::string float_to_string(T val) {
+    // Enough digits to convert the string back to the same value.
+    char buf[64];
+    auto len = std::snprintf(buf, sizeof(buf), "%.*g",
+            std::numeric_limits<T>::max_digits10, static_cast<double>(val));
+    assert(len > 0 && static_cast<std::size_t>(len) < sizeof(buf));
+
+    return std::string(buf, len);
+}
+
+template <FieldDescriptor::CppType T, FieldKind K>
+struct IncrbyHandler {
+    using Type = typename FieldType<T>::Type;
+
+    // Return the value after the increment.
+    static std::string run(MutableFieldRef &field, const StringView &increment) {
+        return _incr(field, increment, IsInteger<T>(), IsFloat<T>());
+    }
+
+    static std::string _incr(MutableFieldRef &field,
+            const StringView &increment,
+            std::true_type,
+            std::false_type) {
+        auto val = checked_add(_current(field), sw::redis::pb::util::sv_to_int64(increment));
+
+        FieldAccess<T, K>::set(field, val);
+
+        return std::to_string(val);
+    }
+
+    static std::string _incr(MutableFieldRef &field,
+            const StringView &increment,
+            std::false_type,
+            std::true_type) {
+        auto res = _current(field) + sw::redis::pb::util::sv_to_double(increment);
+        auto val = static_cast<Type>(res);
+        if (!std::isfinite(val)) {
+            throw Error("increment would produce NaN or Infinity");
+        }
+
+        FieldAccess<T, K>::set(field, val);
+
+        return float_to_string(val);
+    }
+
+    static std::string _incr(MutableFieldRef &,
+            const StringView &,
+            std::false_type,
+            std::false_type) {
+        throw Error("not a numeric field");
+    }
+
+    static Type _current(MutableFieldRef &field) {
+        return _current(field, std::integral_constant<bool, K == FieldKind::MAP_ELEMENT>());
+    }
+
+    static Type _current(MutableFieldRef &field, std::false_type) {
+        return FieldAccess<T, K>::get(field);
+    }
+
+    static Type _current(MutableFieldRef &field, std::true_type) {
+        // Non-existent map element is incremented from 0.
+        return field.map_element_exists() ? FieldAccess<T, K>::get(field) : Type();
+    }
+};
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int IncrbyCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto val = _run(ctx, args);
+
+        _reply(ctx, val, args);
+
+        // Replicate the result instead of the increment, so that the
+        // float result won't differ on replicas.
+        RedisModule_Replicate(ctx, "PB.SET", "sssc",
+                args.key_name, args.type, args.path_name, val.c_str());
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+IncrbyCommand::Args IncrbyCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 5) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.is_float = util::str_case_equal(StringView(argv[0]), "PB.INCRBYFLOAT");
+    args.key_name = argv[1];
+    args.type = argv[2];
+    args.path_name = argv[3];
+    args.path = Path(argv[2], argv[3]);
+    args.increment = StringView(argv[4]);
+
+    return args;
+}
+
+std::string IncrbyCommand::_run(RedisModuleCtx *ctx, const Args &args) const {
+    const auto &path = args.path;
+
+    auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
+    assert(key);
+
+    auto &m = RedisProtobuf::instance();
+
+    std::string val;
+    if (!api::key_exists(key.get(), m.type())) {
+        auto msg = m.proto_factory()->create(path.type());
+        assert(msg);
+
+        MutableFieldRef field(msg.get(), path);
+        val = _incr(field, args);
+
+        if (RedisModule_ModuleTypeSetValue(key.get(), m.type(), msg.get()) != REDISMODULE_OK) {
+            throw Error("failed to set message");
+        }
+
+        msg.release();
+    } else {
+        auto *msg = api::get_msg_by_key(key.get());
+        assert(msg != nullptr);
+
+        MutableFieldRef field(msg, path);
+        val = _incr(field, args);
+    }
+
+    return val;
+}
+
+std::string IncrbyCommand::_incr(MutableFieldRef &field, const Args &args) const {
+    if ((field.is_map() && !field.is_map_element())
+            || (field.is_array() && !field.is_array_element())) {
+        throw Error("cannot increment the whole array or map field");
+    }
+
+    _validate_type(value_type(field), args.is_float);
+
+    using Func = std::string (*)(MutableFieldRef &, const StringView &);
+    static const DispatchTable<IncrbyHandler, Func> table;
+
+    return table.get(field)(field, args.increment);
+}
+
+void IncrbyCommand::_validate_type(gp::FieldDescriptor::CppType type, bool is_float) const {
+    switch (type) {
+    case gp::FieldDescriptor::CPPTYPE_INT32:
+    case gp::FieldDescriptor::CPPTYPE_INT64:
+    case gp::FieldDescriptor::CPPTYPE_UINT32:
+    case gp::FieldDescriptor::CPPTYPE_UINT64:
+        if (is_float) {
+            throw Error("not a floating point field");
+        }
+        break;
+
+    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
+    case gp::FieldDescriptor::CPPTYPE_FLOAT:
+        if (!is_float) {
+            throw Error("not an integer field");
+        }
+        break;
+
+    default:
+        throw Error("not a numeric field");
+    }
+}
+
+void IncrbyCommand::_reply(RedisModuleCtx *ctx, const std::string &val, const Args &args) const {
+    if (args.is_float) {
+        RedisModule_ReplyWithStringBuffer(ctx, val.data(), val.size());
+        return;
+    }
+
+    // Reply uint64 in the same way as PB.GET does.
+    auto integer = util::try_sv_to_int64(val);
+    if (integer) {
+        RedisModule_ReplyWithLongLong(ctx, *integer);
+    } else {
+        RedisModule_ReplyWithLongLong(ctx, util::sv_to_uint64(val));
+    }
+}
+
+}
+
+}
+
+}
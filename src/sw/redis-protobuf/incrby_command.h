@@ -0,0 +1,80 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_INCRBY_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_INCRBY_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include "utils.h"
+#include "field_ref.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.INCRBY key type path increment
+//          PB.INCRBYFLOAT key type path increment
+// return:  For PB.INCRBY, Integer reply: the value after the increment.
+//          For PB.INCRBYFLOAT, Bulk string reply: the value after the increment.
+//          If the key doesn't exist, create an empty message before the increment.
+//          If the map element doesn't exist, it's created with value 0.
+// error:   If the path doesn't exist, or the field is not an integer (PB.INCRBY),
+//          or not a floating point (PB.INCRBYFLOAT), or the increment is invalid,
+//          or the result overflows, or type mismatch return an error reply.
+class IncrbyCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    friend class PatchCommand;
+
+    struct Args {
+        RedisModuleString *key_name;
+
+        // Whether it's PB.INCRBYFLOAT.
+        bool is_float;
+
+        RedisModuleString *type;
+
+        RedisModuleString *path_name;
+
+        Path path;
+
+        StringView increment;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    // Return the value after the increment.
+    std::string _run(RedisModuleCtx *ctx, const Args &args) const;
+
+    std::string _incr(MutableFieldRef &field, const Args &args) const;
+
+    void _validate_type(gp::FieldDescriptor::CppType type, bool is_float) const;
+
+    void _reply(RedisModuleCtx *ctx, const std::string &val, const Args &args) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_INCRBY_COMMANDS_H
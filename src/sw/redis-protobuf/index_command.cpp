@@ -0,0 +1,143 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "index_command.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int IndexCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto &indexes = RedisProtobuf::instance().field_indexes();
+        switch (args.op) {
+        case Args::Op::CREATE:
+            indexes.create(ctx, args.name, args.path, args.kind);
+
+            // Reply when the index is built.
+            _wait(ctx, args.name);
+            break;
+
+        case Args::Op::DROP:
+            RedisModule_ReplyWithLongLong(ctx, indexes.drop(ctx, args.name) ? 1 : 0);
+            break;
+
+        default:
+            assert(false);
+        }
+
+        // Indexes are not saved in RDB, so replicate them to make replicas indexed.
+        RedisModule_ReplicateVerbatim(ctx);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+IndexCommand::Args IndexCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc < 3) {
+        throw WrongArityError();
+    }
+
+    Args args;
+
+    auto op = StringView(argv[1]);
+    if (util::str_case_equal(op, "CREATE")) {
+        if (argc != 5 && argc != 6) {
+            throw WrongArityError();
+        }
+
+        args.op = Args::Op::CREATE;
+        args.path = Path(argv[3], argv[4]);
+        if (argc == 6) {
+            args.kind = _parse_kind(argv[5]);
+        }
+    } else if (util::str_case_equal(op, "DROP")) {
+        if (argc != 3) {
+            throw WrongArityError();
+        }
+
+        args.op = Args::Op::DROP;
+    } else {
+        throw Error("unknown operation: " + util::sv_to_string(op));
+    }
+
+    args.name = util::sv_to_string(argv[2]);
+
+    return args;
+}
+
+void IndexCommand::_wait(RedisModuleCtx *ctx, const std::string &name) const {
+    auto flags = RedisModule_GetContextFlags(ctx);
+    if (flags & (REDISMODULE_CTX_FLAGS_LUA
+                | REDISMODULE_CTX_FLAGS_MULTI
+                | REDISMODULE_CTX_FLAGS_SLAVE)) {
+        // We cannot block the client in a script or a transaction, and should
+        // not block the master client. The index is still built in background.
+        RedisModule_ReplyWithLongLong(ctx, 0);
+        return;
+    }
+
+    // Only the calling client is blocked, while the index is built in background.
+    auto *bc = RedisModule_BlockClient(ctx, _reply_built, nullptr, nullptr, 0);
+    RedisProtobuf::instance().field_indexes().wait(ctx, name, bc);
+}
+
+int IndexCommand::_reply_built(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    try {
+        assert(ctx != nullptr && argv != nullptr && argc > 2);
+
+        auto name = util::sv_to_string(argv[2]);
+        RedisModule_ReplyWithLongLong(ctx,
+                RedisProtobuf::instance().field_indexes().size(ctx, name));
+
+        return REDISMODULE_OK;
+    } catch (const Error &err) {
+        // The index has been dropped before it's built.
+        return api::reply_with_error(ctx, err);
+    }
+}
+
+FieldIndexes::Kind IndexCommand::_parse_kind(const StringView &kind) const {
+    if (util::str_case_equal(kind, "NUMERIC")) {
+        return FieldIndexes::Kind::NUMERIC;
+    } else if (util::str_case_equal(kind, "TAG")) {
+        return FieldIndexes::Kind::TAG;
+    }
+
+    throw Error("invalid index kind: " + util::sv_to_string(kind));
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,79 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_INDEX_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_INDEX_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include "utils.h"
+#include "path.h"
+#include "field_index.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.INDEX CREATE name type path [NUMERIC|TAG]
+//          PB.INDEX DROP name
+// return:  Integer reply: for CREATE, the number of indexed keys. For DROP, 1 if
+//          the index has been dropped, and 0 if it doesn't exist.
+//          The index is built in background, and CREATE blocks the client until it's
+//          built. In a script or a transaction, or on replica, CREATE returns 0 at once.
+// error:   If the index already exists, or the type doesn't exist, or the field
+//          at path cannot be indexed, e.g. repeated or message field, return an
+//          error reply.
+class IndexCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        enum class Op {
+            CREATE = 0,
+            DROP,
+            NONE
+        };
+
+        Op op = Op::NONE;
+
+        std::string name;
+
+        Path path;
+
+        FieldIndexes::Kind kind = FieldIndexes::Kind::NONE;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    FieldIndexes::Kind _parse_kind(const StringView &kind) const;
+
+    // Block the client until the index is built.
+    void _wait(RedisModuleCtx *ctx, const std::string &name) const;
+
+    // Reply callback of the blocked client.
+    static int _reply_built(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_INDEX_COMMANDS_H
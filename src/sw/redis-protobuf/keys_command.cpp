@@ -0,0 +1,130 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "keys_command.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int KeysCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto &indexes = RedisProtobuf::instance().field_indexes();
+        if (!indexes.registered(ctx, args.type)) {
+            // Run the command again, when keys of the type are registered.
+            _wait(ctx, args.type);
+            return REDISMODULE_OK;
+        }
+
+        Optional<std::string> last;
+        auto keys = indexes.keys(ctx, args.type, args.after, args.count, last);
+
+        RedisModule_ReplyWithArray(ctx, 2);
+
+        auto cursor = last ? CURSOR_PREFIX + *last : std::string("0");
+        RedisModule_ReplyWithStringBuffer(ctx, cursor.data(), cursor.size());
+
+        RedisModule_ReplyWithArray(ctx, keys.size());
+        for (const auto &key : keys) {
+            RedisModule_ReplyWithStringBuffer(ctx, key.data(), key.size());
+        }
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+KeysCommand::Args KeysCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 3 && argc != 5) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.type = util::sv_to_string(argv[1]);
+    args.after = _parse_cursor(argv[2]);
+
+    if (argc == 5) {
+        if (!util::str_case_equal(argv[3], "COUNT")) {
+            throw Error("syntax error");
+        }
+
+        try {
+            args.count = util::sv_to_int64(argv[4]);
+        } catch (const Error &) {
+            throw Error("invalid count");
+        }
+
+        if (args.count < 1) {
+            throw Error("syntax error");
+        }
+    }
+
+    return args;
+}
+
+void KeysCommand::_wait(RedisModuleCtx *ctx, const std::string &type) const {
+    auto flags = RedisModule_GetContextFlags(ctx);
+    if (RedisModule_IsBlockedReplyRequest(ctx)
+            || (flags & (REDISMODULE_CTX_FLAGS_LUA | REDISMODULE_CTX_FLAGS_MULTI))) {
+        // We cannot block the client in a script or a transaction.
+        throw Error("keys of the type are being registered, try again later");
+    }
+
+    // Only the calling client is blocked, while keys are registered in background.
+    auto *bc = RedisModule_BlockClient(ctx,
+            [](RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+                KeysCommand cmd;
+                return cmd.run(ctx, argv, argc);
+            },
+            nullptr,
+            nullptr,
+            0);
+
+    RedisProtobuf::instance().field_indexes().wait_registry(ctx, type, bc);
+}
+
+Optional<std::string> KeysCommand::_parse_cursor(const StringView &cursor) const {
+    if (cursor.size() == 1 && *(cursor.data()) == '0') {
+        return {};
+    }
+
+    if (cursor.size() == 0 || *(cursor.data()) != CURSOR_PREFIX) {
+        throw Error("invalid cursor");
+    }
+
+    return Optional<std::string>(cursor.data() + 1, cursor.size() - 1);
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,68 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_KEYS_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_KEYS_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.KEYS type cursor [COUNT count]
+// return:  Array reply: the first item is the next cursor as a bulk string reply,
+//          and "0" means the iteration is finished. The second item is an array
+//          reply of keys holding messages of *type*. Keys are iterated with the
+//          key registry of the type, which is built in background on first use,
+//          and the client is blocked until it's built.
+// error:   If the type doesn't exist, or the cursor is invalid, return an error reply.
+class KeysCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        std::string type;
+
+        // Iterate keys after this key, or from the beginning if it's empty.
+        Optional<std::string> after;
+
+        long long count = 10;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    // Cursor is either "0", or CURSOR_PREFIX + the last visited key.
+    Optional<std::string> _parse_cursor(const StringView &cursor) const;
+
+    // Block the client until keys of the type are registered.
+    void _wait(RedisModuleCtx *ctx, const std::string &type) const;
+
+    static const char CURSOR_PREFIX = ':';
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_KEYS_COMMANDS_H
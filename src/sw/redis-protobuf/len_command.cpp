@@ -82,6 +82,10 @@ long long LenCommand::_len(gp::Message &msg, const Path &path) const {
 }
 
 long long LenCommand::_len(const ConstFieldRef &field) const {
+    if (field.missing()) {
+        throw Error(field.missing_reason());
+    }
+
     if (field.is_map() || field.is_array()) {
         return field.size();
     }
@@ -0,0 +1,181 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "map_access.h"
+#include <cassert>
+
+namespace {
+
+namespace gp = google::protobuf;
+
+const gp::internal::DynamicMapField& get_dynamic_map(const gp::Message &msg,
+        const gp::FieldDescriptor *field);
+
+gp::internal::DynamicMapField& get_mutable_dynamic_map(gp::Message &msg,
+        const gp::FieldDescriptor *field);
+
+using sw::redis::pb::map_access::Map;
+
+template <typename T>
+const T& inner_map(const T &inner);
+
+template <typename T>
+const T& inner_map(T *inner);
+
+const Map::value_type& map_entry(const Map::value_type &kv);
+
+template <typename KeyValuePair>
+const Map::value_type& map_entry(const KeyValuePair &kv);
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace map_access {
+
+const Map& get_map(const gp::Message &msg, const gp::FieldDescriptor *field) {
+    assert(field != nullptr && field->is_map());
+
+    return get_dynamic_map(msg, field).GetMap();
+}
+
+std::size_t bucket_count(const Map &m) {
+    return inner_map(m.elements_).num_buckets_;
+}
+
+void scan_bucket(const Map &m, std::size_t bucket, std::vector<const Map::value_type *> &entries) {
+    const auto &inner = inner_map(m.elements_);
+
+    using InnerMap = std::decay<decltype(inner)>::type;
+    using Node = InnerMap::Node;
+    using Tree = InnerMap::Tree;
+
+    assert(bucket < inner.num_buckets_);
+
+    if (inner.TableEntryIsNonEmptyList(bucket)) {
+        for (auto *node = static_cast<Node *>(inner.table_[bucket]);
+                node != nullptr;
+                node = node->next) {
+            entries.push_back(&map_entry(node->kv));
+        }
+    } else if (inner.TableEntryIsTree(bucket)) {
+        // A tree is shared by two buckets, i.e. bucket and bucket ^ 1,
+        // so only visit entries that belong to this bucket.
+        auto *tree = static_cast<Tree *>(inner.table_[bucket]);
+        for (auto iter = tree->begin(); iter != tree->end(); ++iter) {
+            const auto &entry = map_entry(InnerMap::NodeFromTreeIterator(iter)->kv);
+            if (inner.BucketNumber(entry.first) == bucket) {
+                entries.push_back(&entry);
+            }
+        }
+    }
+}
+
+const gp::MapValueRef* find_value(const gp::Message &msg,
+        const gp::FieldDescriptor *field,
+        const gp::MapKey &key) {
+    const auto &m = get_map(msg, field);
+    auto iter = m.find(key);
+    if (iter == m.end()) {
+        return nullptr;
+    }
+
+    return &(iter->second);
+}
+
+gp::MapValueRef insert_or_lookup_value(gp::Message &msg,
+        const gp::FieldDescriptor *field,
+        const gp::MapKey &key) {
+    assert(field != nullptr && field->is_map());
+
+    // *val* refers to the value in the map, so there's no need to find it again.
+    gp::MapValueRef val;
+    get_mutable_dynamic_map(msg, field).InsertOrLookupMapValue(key, &val);
+
+    return val;
+}
+
+bool erase(gp::Message &msg, const gp::FieldDescriptor *field, const gp::MapKey &key) {
+    assert(field != nullptr && field->is_map());
+
+    return get_mutable_dynamic_map(msg, field).DeleteMapValue(key);
+}
+
+void append_string(gp::MapValueRef &value, const std::string &str) {
+    // MapValueRef only has a setter, which copies the whole string. However,
+    // the value is a std::string owned by the map, which has been marked as
+    // modified when *value* is looked up, so it's safe to modify it in place.
+    const_cast<std::string&>(value.GetStringValue()).append(str);
+}
+
+}
+
+}
+
+}
+
+}
+
+namespace {
+
+// The following is hacking, hacking, and hacking!!!
+
+const gp::internal::DynamicMapField& get_dynamic_map(const gp::Message &msg,
+        const gp::FieldDescriptor *field) {
+    const auto *reflection =
+        static_cast<const gp::internal::GeneratedMessageReflection*>(msg.GetReflection());
+    const auto &map_base = reflection->GetRaw<gp::internal::MapFieldBase>(msg, field);
+
+    return static_cast<const gp::internal::DynamicMapField&>(map_base);
+}
+
+gp::internal::DynamicMapField& get_mutable_dynamic_map(gp::Message &msg,
+        const gp::FieldDescriptor *field) {
+    const auto *reflection =
+        static_cast<const gp::internal::GeneratedMessageReflection*>(msg.GetReflection());
+    auto *map_base = reflection->MutableRaw<gp::internal::MapFieldBase>(&msg, field);
+
+    return *static_cast<gp::internal::DynamicMapField*>(map_base);
+}
+
+// Entries of the map are saved in a chaining hash table, i.e. Map::InnerMap.
+// Depending on the version of protobuf, the map holds the hash table by value
+// or by pointer, and a node of the hash table holds the entry by value or by pointer.
+
+template <typename T>
+const T& inner_map(const T &inner) {
+    return inner;
+}
+
+template <typename T>
+const T& inner_map(T *inner) {
+    return *inner;
+}
+
+const Map::value_type& map_entry(const Map::value_type &kv) {
+    return kv;
+}
+
+template <typename KeyValuePair>
+const Map::value_type& map_entry(const KeyValuePair &kv) {
+    return *kv.value();
+}
+
+}
@@ -0,0 +1,78 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_MAP_ACCESS_H
+#define SEWENEW_REDISPROTOBUF_MAP_ACCESS_H
+
+#include <string>
+#include <google/protobuf/message.h>
+#include <google/protobuf/map_field.h>
+#include <google/protobuf/map.h>
+#include <vector>
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Protobuf reflection doesn't expose the map of a map field, so we have to
+// access the underlying DynamicMapField. All the hacking is done here.
+namespace map_access {
+
+namespace gp = google::protobuf;
+
+using Map = gp::Map<gp::MapKey, gp::MapValueRef>;
+
+// Get the map for reading. It doesn't mark the map as modified.
+const Map& get_map(const gp::Message &msg, const gp::FieldDescriptor *field);
+
+// Number of buckets of the map's hash table, which is a power of 2.
+std::size_t bucket_count(const Map &m);
+
+// Append entries in the given bucket of the map's hash table to *entries*.
+void scan_bucket(const Map &m, std::size_t bucket, std::vector<const Map::value_type *> &entries);
+
+// Find the value with a single lookup, and it doesn't mark the map as modified.
+// Return nullptr, if the key doesn't exist.
+const gp::MapValueRef* find_value(const gp::Message &msg,
+        const gp::FieldDescriptor *field,
+        const gp::MapKey &key);
+
+// Find the value for writing with a single lookup. If the key doesn't exist,
+// insert a default value. The map is marked as modified, so that protobuf can
+// sync the change to the repeated field view of the map.
+gp::MapValueRef insert_or_lookup_value(gp::Message &msg,
+        const gp::FieldDescriptor *field,
+        const gp::MapKey &key);
+
+// Erase the key with a single lookup. The map is marked as modified.
+// Return whether the key existed.
+bool erase(gp::Message &msg, const gp::FieldDescriptor *field, const gp::MapKey &key);
+
+// Append to the string value in place, instead of copying the whole string.
+// *value* must be a writable reference, i.e. returned by insert_or_lookup_value.
+void append_string(gp::MapValueRef &value, const std::string &str);
+
+}
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_MAP_ACCESS_H
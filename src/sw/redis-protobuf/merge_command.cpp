@@ -20,6 +20,7 @@
 #include "utils.h"
 #include "field_ref.h"
 #include "set_command.h"
+#include "field_mask.h"
 
 namespace sw {
 
@@ -35,8 +36,26 @@ int MergeCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) c
 
         auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
         if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
-            SetCommand set_cmd;
-            set_cmd._run(ctx, argv, argc);
+            if (!args.masked) {
+                SetCommand set_cmd;
+                set_cmd._run(ctx, argv, argc);
+            } else {
+                // Only set the masked fields of the new message.
+                auto msg = RedisProtobuf::instance().proto_factory()->create(args.path.type());
+                assert(msg);
+
+                _merge(args, *msg);
+
+                if (RedisModule_ModuleTypeSetValue(key.get(),
+                            RedisProtobuf::instance().type(),
+                            msg.get()) != REDISMODULE_OK) {
+                    throw Error("failed to set message");
+                }
+
+                msg.release();
+
+                RedisModule_ReplicateVerbatim(ctx);
+            }
 
             return RedisModule_ReplyWithLongLong(ctx, 0);
         }
@@ -63,53 +82,90 @@ int MergeCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) c
 MergeCommand::Args MergeCommand::_parse_args(RedisModuleString **argv, int argc) const {
     assert(argv != nullptr);
 
-    if (argc != 4 && argc != 5) {
+    if (argc < 4) {
         throw WrongArityError();
     }
 
-    Path path;
-    StringView val;
-    if (argc == 4) {
-        path = Path(argv[2]);
-        val = StringView(argv[3]);
+    Args args;
+    args.key_name = argv[1];
+
+    auto pos = _parse_opts(argv, argc, args);
+
+    auto left = argc - pos;
+    if (left == 2) {
+        args.path = Path(argv[pos]);
+        args.val = StringView(argv[pos + 1]);
+    } else if (left == 3) {
+        args.path = Path(argv[pos], argv[pos + 1]);
+        args.val = StringView(argv[pos + 2]);
     } else {
-        path = Path(argv[2], argv[3]);
-        val = StringView(argv[4]);
+        throw WrongArityError();
+    }
+
+    return args;
+}
+
+int MergeCommand::_parse_opts(RedisModuleString **argv, int argc, Args &args) const {
+    auto idx = 2;
+    while (idx < argc) {
+        auto opt = StringView(argv[idx]);
+
+        if (util::str_case_equal(opt, "--MASK")) {
+            if (idx + 1 >= argc) {
+                throw Error("syntax error");
+            }
+
+            ++idx;
+
+            args.mask = StringView(argv[idx]);
+            args.masked = true;
+        } else {
+            // Finish parsing options.
+            break;
+        }
+
+        ++idx;
     }
 
-    return {argv[1], std::move(path), std::move(val)};
+    return idx;
 }
 
 void MergeCommand::_merge(const Args &args, gp::Message &msg) const {
-    const auto &path = args.path;
-    if (path.empty()) {
-        _merge_msg(path.type(), args.val, msg);
+    if (args.path.empty()) {
+        _merge_msg(args, msg);
     } else {
-        _merge_sub_msg(path, args.val, msg);
+        _merge_sub_msg(args, msg);
     }
 }
 
-void MergeCommand::_merge_msg(const std::string &type,
-        const StringView &val,
-        gp::Message &msg) const {
+void MergeCommand::_merge_msg(const Args &args, gp::Message &msg) const {
+    const auto &type = args.path.type();
     if (type != msg.GetTypeName()) {
         throw Error("type mismatch");
     }
 
-    auto other = RedisProtobuf::instance().proto_factory()->create(type, val);
+    auto other = RedisProtobuf::instance().proto_factory()->create(type, args.val);
     assert(other);
 
-    msg.MergeFrom(*other);
+    if (args.masked) {
+        auto mask = field_mask::parse(args.mask, other->GetDescriptor());
+        field_mask::merge(*other, mask, msg);
+    } else {
+        msg.MergeFrom(*other);
+    }
 }
 
-void MergeCommand::_merge_sub_msg(const Path &path,
-        const StringView &val,
-        gp::Message &msg) const {
-    MutableFieldRef field(&msg, path);
-    auto sub_msg = RedisProtobuf::instance().proto_factory()->create(field.msg_type(), val);
+void MergeCommand::_merge_sub_msg(const Args &args, gp::Message &msg) const {
+    MutableFieldRef field(&msg, args.path);
+    const auto &type = field.is_map_element() ? field.mapped_msg_type() : field.msg_type();
+    auto sub_msg = RedisProtobuf::instance().proto_factory()->create(type, args.val);
     assert(sub_msg);
 
-    field.merge(*sub_msg);
+    if (args.masked) {
+        field.merge(*sub_msg, field_mask::parse(args.mask, sub_msg->GetDescriptor()));
+    } else {
+        field.merge(*sub_msg);
+    }
 }
 
 }
@@ -28,9 +28,11 @@ namespace redis {
 
 namespace pb {
 
-// command: PB.MERGE key type [path] value
+// command: PB.MERGE key [--MASK mask] type [path] value
 // return:  Integer reply: If the key exists, return 1. Otherwise, return 0.
 //          If key doesn't exist, this command behaves as PB.SET.
+//          If --MASK is specified, e.g. "a,b.c", only the masked fields are
+//          overwritten, and other fields of value are ignored.
 // error:   If the type doesn't match the protobuf message type of the key,
 //          or path doesn't exist, return an error reply.
 class MergeCommand {
@@ -42,15 +44,22 @@ private:
         RedisModuleString *key_name;
         Path path;
         StringView val;
+
+        // Comma separated field paths, only if masked is true.
+        StringView mask;
+
+        bool masked = false;
     };
 
     Args _parse_args(RedisModuleString **argv, int argc) const;
 
+    int _parse_opts(RedisModuleString **argv, int argc, Args &args) const;
+
     void _merge(const Args &args, gp::Message &msg) const;
 
-    void _merge_msg(const std::string &type, const StringView &val, gp::Message &msg) const;
+    void _merge_msg(const Args &args, gp::Message &msg) const;
 
-    void _merge_sub_msg(const Path &path, const StringView &val, gp::Message &msg) const;
+    void _merge_sub_msg(const Args &args, gp::Message &msg) const;
 };
 
 }
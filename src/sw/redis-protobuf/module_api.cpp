@@ -16,6 +16,7 @@
 
 #include "module_api.h"
 #include <cassert>
+#include "redis_protobuf.h"
 
 namespace sw {
 
@@ -48,7 +49,14 @@ RedisKey open_key(RedisModuleCtx *ctx, RedisModuleString *name, KeyMode key_mode
         assert(false);
     }
 
-    return RedisKey(static_cast<RedisModuleKey *>(RedisModule_OpenKey(ctx, name, mode)));
+    RedisKeyCloser closer;
+    if (mode & REDISMODULE_WRITE) {
+        // The key might be modified.
+        RedisProtobuf::instance().field_indexes().touch(ctx, name);
+        closer.writable = true;
+    }
+
+    return RedisKey(static_cast<RedisModuleKey *>(RedisModule_OpenKey(ctx, name, mode)), closer);
 }
 
 bool key_exists(RedisModuleKey *key, RedisModuleType *key_type) {
@@ -80,6 +88,21 @@ google::protobuf::Message* get_msg_by_key(RedisModuleKey *key) {
     return msg;
 }
 
+void RedisKeyCloser::operator()(RedisModuleKey *key) const {
+    if (writable) {
+        // The message might have been modified or replaced, so its element indexes are stale.
+        auto &m = RedisProtobuf::instance();
+        if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_MODULE
+                && RedisModule_ModuleTypeGetType(key) == m.type()) {
+            m.element_index().invalidate(
+                    static_cast<const google::protobuf::Message *>(
+                        RedisModule_ModuleTypeGetValue(key)));
+        }
+    }
+
+    RedisModule_CloseKey(key);
+}
+
 }
 
 }
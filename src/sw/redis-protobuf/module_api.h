@@ -64,13 +64,36 @@ void verbose(RedisModuleCtx *ctx, const char *fmt, Args &&...args) {
 }
 
 struct RedisKeyCloser {
-    void operator()(RedisModuleKey *key) const {
-        RedisModule_CloseKey(key);
-    }
+    // Whether the key is opened for writing.
+    bool writable = false;
+
+    void operator()(RedisModuleKey *key) const;
 };
 
 using RedisKey = std::unique_ptr<RedisModuleKey, RedisKeyCloser>;
 
+struct CallReplyDeleter {
+    void operator()(RedisModuleCallReply *reply) const {
+        RedisModule_FreeCallReply(reply);
+    }
+};
+
+using CallReply = std::unique_ptr<RedisModuleCallReply, CallReplyDeleter>;
+
+class RedisStringDeleter {
+public:
+    explicit RedisStringDeleter(RedisModuleCtx *ctx = nullptr) : _ctx(ctx) {}
+
+    void operator()(RedisModuleString *str) const {
+        RedisModule_FreeString(_ctx, str);
+    }
+
+private:
+    RedisModuleCtx *_ctx;
+};
+
+using RedisString = std::unique_ptr<RedisModuleString, RedisStringDeleter>;
+
 enum class KeyMode {
     READONLY,
     WRITEONLY,
@@ -0,0 +1,248 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "mscan_command.h"
+#include <algorithm>
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "map_access.h"
+
+namespace {
+
+// Same as Redis' dictScan, increase the reversed cursor, so that buckets that have
+// been visited are not visited again, even if the hash table is resized.
+uint64_t next_cursor(uint64_t cursor, uint64_t mask);
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int MScanCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto key = api::open_key(ctx, args.key_name, api::KeyMode::READONLY);
+        if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
+            _reply_with_empty_result(ctx);
+        } else {
+            auto *msg = api::get_msg_by_key(key.get());
+            assert(msg != nullptr);
+
+            _scan(ctx, *msg, args);
+        }
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+}
+
+MScanCommand::Args MScanCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc < 5) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.key_name = argv[1];
+
+    GetArgs get_args;
+    auto pos = get_reply::parse_opts(argv, argc, get_args);
+    if (pos + 3 > argc) {
+        throw WrongArityError();
+    }
+
+    args.format = get_args.format;
+    args.path = Path(argv[pos], argv[pos + 1]);
+    if (args.path.empty()) {
+        throw Error("empty path");
+    }
+
+    try {
+        args.cursor = util::sv_to_uint64(argv[pos + 2]);
+    } catch (const Error &) {
+        throw Error("invalid cursor");
+    }
+
+    _parse_scan_opts(argv, argc, pos + 3, args);
+
+    return args;
+}
+
+void MScanCommand::_parse_scan_opts(RedisModuleString **argv,
+        int argc,
+        int pos,
+        Args &args) const {
+    for (auto idx = pos; idx < argc; idx += 2) {
+        if (idx + 1 >= argc) {
+            throw Error("syntax error");
+        }
+
+        auto opt = StringView(argv[idx]);
+        if (util::str_case_equal(opt, "COUNT")) {
+            try {
+                args.count = util::sv_to_int64(argv[idx + 1]);
+            } catch (const Error &) {
+                throw Error("invalid count");
+            }
+
+            if (args.count < 1) {
+                throw Error("syntax error");
+            }
+        } else if (util::str_case_equal(opt, "MATCH")) {
+            args.pattern = Optional<std::string>(util::sv_to_string(argv[idx + 1]));
+        } else {
+            throw Error("syntax error");
+        }
+    }
+}
+
+void MScanCommand::_reply_with_empty_result(RedisModuleCtx *ctx) const {
+    RedisModule_ReplyWithArray(ctx, 2);
+    RedisModule_ReplyWithStringBuffer(ctx, "0", 1);
+    RedisModule_ReplyWithArray(ctx, 0);
+}
+
+void MScanCommand::_scan(RedisModuleCtx *ctx, const gp::Message &msg, const Args &args) const {
+    if (msg.GetTypeName() != args.path.type()) {
+        throw Error("type mismatch");
+    }
+
+    ConstFieldRef field(&msg, args.path);
+    if (field.missing()) {
+        throw Error(field.missing_reason());
+    }
+
+    if (!field.is_map() || field.is_map_element()) {
+        throw Error("not a map");
+    }
+
+    const auto &m = field.get_map();
+    auto mask = static_cast<uint64_t>(map_access::bucket_count(m)) - 1;
+
+    // Visit entries bucket by bucket, until at least *count* entries are visited.
+    // Also limit the number of visited buckets, in case most of them are empty,
+    // as Redis' HSCAN does.
+    std::vector<const map_access::Map::value_type *> entries;
+    auto cursor = args.cursor;
+    auto max_buckets = args.count * 10;
+    do {
+        map_access::scan_bucket(m, cursor & mask, entries);
+
+        cursor = next_cursor(cursor, mask);
+    } while (cursor != 0
+            && entries.size() < static_cast<std::size_t>(args.count)
+            && --max_buckets > 0);
+
+    if (args.pattern) {
+        // Only reply with entries matching the pattern.
+        auto last = std::remove_if(entries.begin(), entries.end(),
+                [this, &args](const map_access::Map::value_type *entry) {
+                    return !_match(entry->first, *args.pattern);
+                });
+        entries.erase(last, entries.end());
+    }
+
+    RedisModule_ReplyWithArray(ctx, 2);
+
+    auto cursor_str = std::to_string(cursor);
+    RedisModule_ReplyWithStringBuffer(ctx, cursor_str.data(), cursor_str.size());
+
+    RedisModule_ReplyWithArray(ctx, entries.size());
+
+    for (const auto *entry : entries) {
+        try {
+            get_reply::reply_with_map_kv(ctx, field, args.format, entry->first, entry->second);
+        } catch (const Error &e) {
+            api::reply_with_error(ctx, e);
+        }
+    }
+}
+
+bool MScanCommand::_match(const gp::MapKey &key, const std::string &pattern) const {
+    if (key.type() == gp::FieldDescriptor::CPPTYPE_STRING) {
+        return util::glob_match(pattern, key.GetStringValue());
+    }
+
+    return util::glob_match(pattern, _key_to_string(key));
+}
+
+std::string MScanCommand::_key_to_string(const gp::MapKey &key) const {
+    switch (key.type()) {
+    case gp::FieldDescriptor::CPPTYPE_INT32:
+        return std::to_string(key.GetInt32Value());
+
+    case gp::FieldDescriptor::CPPTYPE_INT64:
+        return std::to_string(key.GetInt64Value());
+
+    case gp::FieldDescriptor::CPPTYPE_UINT32:
+        return std::to_string(key.GetUInt32Value());
+
+    case gp::FieldDescriptor::CPPTYPE_UINT64:
+        return std::to_string(key.GetUInt64Value());
+
+    case gp::FieldDescriptor::CPPTYPE_BOOL:
+        return std::to_string(static_cast<int>(key.GetBoolValue()));
+
+    case gp::FieldDescriptor::CPPTYPE_STRING:
+        return key.GetStringValue();
+
+    default:
+        assert(false);
+        return "";
+    }
+}
+
+}
+
+}
+
+}
+
+namespace {
+
+uint64_t reverse_bits(uint64_t v) {
+    uint64_t s = 8 * sizeof(v);
+    uint64_t mask = ~0ULL;
+    while ((s >>= 1) > 0) {
+        mask ^= (mask << s);
+        v = ((v >> s) & mask) | ((v << s) & ~mask);
+    }
+
+    return v;
+}
+
+uint64_t next_cursor(uint64_t cursor, uint64_t mask) {
+    // Set the unmasked bits, so that incrementing the reversed cursor
+    // operates on the masked bits.
+    cursor |= ~mask;
+
+    cursor = reverse_bits(cursor);
+    ++cursor;
+
+    return reverse_bits(cursor);
+}
+
+}
@@ -0,0 +1,81 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_MSCAN_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_MSCAN_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "field_ref.h"
+#include "get_reply.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.MSCAN key [--FORMAT BINARY|JSON] type path cursor [COUNT count] [MATCH pattern]
+// return:  Array reply: the first item is the next cursor as a bulk string reply,
+//          and "0" means the iteration is finished. The second item is an array
+//          reply of the scanned key-value pairs, and each pair is replied in the
+//          same way as PB.GET does for a map field. If the key doesn't exist,
+//          return "0" and an empty array.
+// error:   If the path doesn't exist, or it's not a map, or the cursor is invalid,
+//          or type mismatch return an error reply.
+class MScanCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    using Format = GetArgs::Format;
+
+    struct Args {
+        RedisModuleString *key_name;
+
+        Format format = Format::NONE;
+
+        Path path;
+
+        uint64_t cursor = 0;
+
+        long long count = 10;
+
+        Optional<std::string> pattern;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    void _parse_scan_opts(RedisModuleString **argv, int argc, int pos, Args &args) const;
+
+    void _reply_with_empty_result(RedisModuleCtx *ctx) const;
+
+    void _scan(RedisModuleCtx *ctx, const gp::Message &msg, const Args &args) const;
+
+    bool _match(const gp::MapKey &key, const std::string &pattern) const;
+
+    std::string _key_to_string(const gp::MapKey &key) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_MSCAN_COMMANDS_H
@@ -0,0 +1,130 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "mset_command.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int MSetCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        if (RedisModule_IsKeysPositionRequest(ctx)) {
+            _reply_with_keys(ctx, argv, argc);
+
+            return REDISMODULE_OK;
+        }
+
+        auto args = _parse_args(argv, argc);
+        auto &set_args = args.set_args;
+
+        RedisModule_ReplyWithArray(ctx, (argc - args.key_pos) / 2);
+
+        for (auto idx = args.key_pos; idx != argc; idx += 2) {
+            set_args.key_name = argv[idx];
+            set_args.val = StringView(argv[idx + 1]);
+
+            _set(ctx, set_args);
+        }
+
+        RedisModule_ReplicateVerbatim(ctx);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+MSetCommand::Args MSetCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc < 4) {
+        throw WrongArityError();
+    }
+
+    Args args;
+
+    SetCommand set_cmd;
+    auto pos = set_cmd._parse_opts(argv, argc, args.set_args, 1);
+    if (pos + 1 >= argc) {
+        throw WrongArityError();
+    }
+
+    // Keys follow the KEYS keyword, so that a key is never taken as a path.
+    auto keys_pos = pos + 1;
+    if (!util::str_case_equal(argv[keys_pos], "KEYS")) {
+        args.set_args.path = Path(argv[pos], argv[keys_pos]);
+        ++keys_pos;
+    } else {
+        args.set_args.path = Path(argv[pos]);
+    }
+
+    if (keys_pos >= argc || !util::str_case_equal(argv[keys_pos], "KEYS")) {
+        throw Error("syntax error: KEYS should be followed by keys");
+    }
+
+    args.key_pos = keys_pos + 1;
+
+    if (args.key_pos >= argc || (argc - args.key_pos) % 2 != 0) {
+        throw WrongArityError();
+    }
+
+    // Resolve the type only once, instead of failing on each key.
+    const auto &type = args.set_args.path.type();
+    if (RedisProtobuf::instance().proto_factory()->descriptor(type) == nullptr) {
+        throw Error("unknown protobuf type: " + type);
+    }
+
+    return args;
+}
+
+void MSetCommand::_reply_with_keys(RedisModuleCtx *ctx,
+        RedisModuleString **argv,
+        int argc) const {
+    auto args = _parse_args(argv, argc);
+    for (auto idx = args.key_pos; idx < argc; idx += 2) {
+        RedisModule_KeyAtPos(ctx, idx);
+    }
+}
+
+void MSetCommand::_set(RedisModuleCtx *ctx, SetCommand::Args &args) const {
+    // Nothing has been replied, if an error is thrown, so that we can reply
+    // the error in place of the key.
+    try {
+        SetCommand set_cmd;
+        auto res = set_cmd._run(ctx, args);
+
+        RedisModule_ReplyWithLongLong(ctx, res);
+    } catch (const Error &e) {
+        api::reply_with_error(ctx, e);
+    }
+}
+
+}
+
+}
+
+}
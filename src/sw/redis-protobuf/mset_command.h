@@ -0,0 +1,63 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_MSET_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_MSET_COMMANDS_H
+
+#include "module_api.h"
+#include "utils.h"
+#include "set_command.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.MSET [--NX|--XX] [--EX seconds | --PX milliseconds] type [path]
+//              KEYS key value [key value ...]
+// return:  Array reply: each item is the reply of PB.SET with the options, type
+//          and path on the corresponding key and value, or an error reply if
+//          failed to set that key.
+// error:   If the type doesn't exist, or the path is invalid, return an error reply.
+class MSetCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        // Only options and path are used.
+        SetCommand::Args set_args;
+
+        // Position of the first key.
+        int key_pos;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    // Reply with the positions of keys for Redis Cluster.
+    void _reply_with_keys(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+    void _set(RedisModuleCtx *ctx, SetCommand::Args &args) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_MSET_COMMANDS_H
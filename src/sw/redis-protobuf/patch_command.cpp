@@ -0,0 +1,544 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "patch_command.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <google/protobuf/util/json_util.h>
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "set_command.h"
+#include "del_command.h"
+#include "append_command.h"
+#include "incrby_command.h"
+#include "field_type.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace {
+
+// Scanner of JSON text, which has already been validated by the JSON parser,
+// so that it only needs to find the boundary of each token.
+class JsonScanner {
+public:
+    explicit JsonScanner(const StringView &json) : _cur(json.data()), _end(json.data() + json.size()) {}
+
+    // Return the raw text of the "value" member of each object in the top level array.
+    std::vector<StringView> values();
+
+private:
+    StringView _member_value();
+
+    StringView _skip_value();
+
+    void _skip_string();
+
+    void _skip_space();
+
+    char _next() {
+        return _cur != _end ? *_cur++ : '\0';
+    }
+
+    char _peek() {
+        _skip_space();
+
+        return _cur != _end ? *_cur : '\0';
+    }
+
+    const char *_cur;
+
+    const char *_end;
+};
+
+std::vector<StringView> JsonScanner::values() {
+    std::vector<StringView> vals;
+    if (_peek() != '[') {
+        return vals;
+    }
+
+    _next();
+
+    if (_peek() == ']') {
+        return vals;
+    }
+
+    while (true) {
+        vals.push_back(_member_value());
+
+        if (_peek() != ',') {
+            break;
+        }
+
+        _next();
+    }
+
+    return vals;
+}
+
+StringView JsonScanner::_member_value() {
+    if (_peek() != '{') {
+        _skip_value();
+        return {};
+    }
+
+    _next();
+
+    StringView val;
+    if (_peek() == '}') {
+        _next();
+        return val;
+    }
+
+    while (true) {
+        _skip_space();
+        auto name = _skip_value();
+
+        // Skip ':'.
+        _peek();
+        _next();
+
+        auto member = _skip_value();
+        if (name.size() == 7 && std::memcmp(name.data(), "\"value\"", 7) == 0) {
+            val = member;
+        }
+
+        if (_peek() != ',') {
+            _next();
+            break;
+        }
+
+        _next();
+    }
+
+    return val;
+}
+
+StringView JsonScanner::_skip_value() {
+    _skip_space();
+
+    auto *begin = _cur;
+    switch (_peek()) {
+    case '"':
+        _skip_string();
+        break;
+
+    case '{':
+    case '[': {
+        auto depth = 0;
+        do {
+            auto c = _peek();
+            if (c == '"') {
+                _skip_string();
+                continue;
+            }
+
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                --depth;
+            }
+
+            _next();
+        } while (depth > 0 && _cur != _end);
+        break;
+    }
+
+    default:
+        // Number, true, false or null.
+        while (_cur != _end && std::strchr(",]} \t\r\n", *_cur) == nullptr) {
+            ++_cur;
+        }
+        break;
+    }
+
+    return StringView(begin, _cur - begin);
+}
+
+void JsonScanner::_skip_string() {
+    assert(_cur != _end && *_cur == '"');
+
+    ++_cur;
+    while (_cur != _end) {
+        auto c = *_cur++;
+        if (c == '\\' && _cur != _end) {
+            ++_cur;
+        } else if (c == '"') {
+            break;
+        }
+    }
+}
+
+void JsonScanner::_skip_space() {
+    while (_cur != _end && std::strchr(" \t\r\n", *_cur) != nullptr) {
+        ++_cur;
+    }
+}
+
+bool is_integer(const StringView &token) {
+    auto *begin = token.data();
+    auto *end = token.data() + token.size();
+    if (begin != end && *begin == '-') {
+        ++begin;
+    }
+
+    return begin != end && std::all_of(begin, end, [](char c) { return c >= '0' && c <= '9'; });
+}
+
+}
+
+int PatchCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
+        assert(key);
+
+        _patch(*key, args);
+
+        RedisModule_ReplyWithLongLong(ctx, args.operations.size());
+
+        // Replicate the whole patch, so that it's also applied atomically on replicas.
+        RedisModule_ReplicateVerbatim(ctx);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+PatchCommand::Args PatchCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 4) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.key_name = argv[1];
+    args.type = Path(argv[2]).type();
+
+    // Parse all operations before modifying the message.
+    args.operations = _parse_patch(args.type, argv[3]);
+
+    return args;
+}
+
+auto PatchCommand::_parse_patch(const std::string &type, const StringView &patch) const
+    -> std::vector<Operation> {
+    gp::ListValue operations;
+    auto status = gp::util::JsonStringToMessage(gp::StringPiece(patch.data(), patch.size()),
+            &operations);
+    if (!status.ok()) {
+        throw Error("invalid patch: " + status.ToString());
+    }
+
+    // Numbers are converted from the raw JSON text, since gp::Value saves them
+    // as double, which cannot hold all int64 and uint64 values.
+    auto raw_values = _raw_values(patch);
+    assert(raw_values.size() == static_cast<std::size_t>(operations.values_size()));
+
+    std::vector<Operation> ops;
+    ops.reserve(operations.values_size());
+    for (auto idx = 0; idx != operations.values_size(); ++idx) {
+        ops.push_back(_parse_operation(type, operations.values(idx), raw_values[idx]));
+    }
+
+    return ops;
+}
+
+std::vector<StringView> PatchCommand::_raw_values(const StringView &patch) const {
+    JsonScanner scanner(patch);
+
+    return scanner.values();
+}
+
+auto PatchCommand::_parse_operation(const std::string &type,
+        const gp::Value &operation,
+        const StringView &raw_value) const -> Operation {
+    if (operation.kind_case() != gp::Value::kStructValue) {
+        throw Error("invalid patch: operation should be an object");
+    }
+
+    const auto &fields = operation.struct_value().fields();
+
+    auto get_string = [&fields](const std::string &name) -> const std::string& {
+        auto iter = fields.find(name);
+        if (iter == fields.end() || iter->second.kind_case() != gp::Value::kStringValue) {
+            throw Error("invalid patch: no " + name + " specified");
+        }
+
+        return iter->second.string_value();
+    };
+
+    Operation op;
+    op.op = _parse_op(get_string("op"));
+    op.path = Path(type, get_string("path"));
+
+    auto iter = fields.find("value");
+    if (op.op == Operation::Op::REMOVE) {
+        if (iter != fields.end()) {
+            throw Error("invalid patch: remove takes no value");
+        }
+    } else {
+        if (iter == fields.end()) {
+            throw Error("invalid patch: no value specified");
+        }
+
+        op.value = _value_to_string(iter->second, raw_value);
+    }
+
+    return op;
+}
+
+auto PatchCommand::_parse_op(const std::string &op) const -> Operation::Op {
+    if (op == "add") {
+        return Operation::Op::ADD;
+    } else if (op == "replace") {
+        return Operation::Op::REPLACE;
+    } else if (op == "remove") {
+        return Operation::Op::REMOVE;
+    } else if (op == "increment") {
+        return Operation::Op::INCREMENT;
+    } else if (op == "append") {
+        return Operation::Op::APPEND;
+    } else {
+        throw Error("invalid patch: unknown op: " + op);
+    }
+}
+
+std::string PatchCommand::_value_to_string(const gp::Value &value,
+        const StringView &raw_value) const {
+    // Convert the value to the string form of PB.SET, so that it's converted
+    // to the type of the field in the same way.
+    switch (value.kind_case()) {
+    case gp::Value::kStringValue:
+        return value.string_value();
+
+    case gp::Value::kNumberValue: {
+        if (is_integer(raw_value)) {
+            // Keep the exact value of large integers.
+            return std::string(raw_value.data(), raw_value.size());
+        }
+
+        auto num = value.number_value();
+        char buf[64];
+        auto len = std::snprintf(buf, sizeof(buf), "%.17g", num);
+        assert(len > 0 && static_cast<std::size_t>(len) < sizeof(buf));
+
+        return std::string(buf, len);
+    }
+
+    case gp::Value::kBoolValue:
+        return value.bool_value() ? "true" : "false";
+
+    case gp::Value::kStructValue: {
+        // Message value.
+        std::string json;
+        auto status = gp::util::MessageToJsonString(value.struct_value(), &json);
+        if (!status.ok()) {
+            throw Error("invalid patch: " + status.ToString());
+        }
+
+        return json;
+    }
+
+    default:
+        throw Error("invalid patch: value should be string, number, bool or object");
+    }
+}
+
+void PatchCommand::_patch(RedisModuleKey &key, const Args &args) const {
+    auto &m = RedisProtobuf::instance();
+
+    if (!api::key_exists(&key, m.type())) {
+        auto msg = m.proto_factory()->create(args.type);
+        assert(msg);
+
+        try {
+            _apply(*msg, args.operations);
+        } catch (const Error &) {
+            m.element_index().invalidate(msg.get());
+            throw;
+        }
+
+        if (RedisModule_ModuleTypeSetValue(&key, m.type(), msg.get()) != REDISMODULE_OK) {
+            throw Error("failed to set message");
+        }
+
+        msg.release();
+    } else {
+        auto *msg = api::get_msg_by_key(&key);
+        assert(msg != nullptr);
+
+        if (msg->GetTypeName() != args.type) {
+            throw Error("type mismatch");
+        }
+
+        // Validate all operations before modifying the message, so that nothing
+        // changes if any operation fails.
+        _validate(*msg, args.operations);
+
+        _apply(*msg, args.operations);
+    }
+}
+
+void PatchCommand::_validate(gp::Message &msg, const std::vector<Operation> &operations) const {
+    // Only copy the modified fields, instead of the whole message.
+    auto fields = _modified_fields(msg, operations);
+
+    auto *reflection = msg.GetReflection();
+    MsgUPtr modified(msg.New());
+    reflection->SwapFields(&msg, modified.get(), fields);
+
+    MsgUPtr copy(msg.New());
+    copy->CopyFrom(*modified);
+
+    reflection->SwapFields(&msg, modified.get(), fields);
+
+    auto &element_index = RedisProtobuf::instance().element_index();
+    try {
+        _apply(*copy, operations);
+    } catch (const Error &) {
+        element_index.invalidate(copy.get());
+        throw;
+    }
+
+    element_index.invalidate(copy.get());
+}
+
+auto PatchCommand::_modified_fields(const gp::Message &msg,
+        const std::vector<Operation> &operations) const
+    -> std::vector<const gp::FieldDescriptor *> {
+    const auto *desc = msg.GetDescriptor();
+    assert(desc != nullptr);
+
+    std::vector<const gp::FieldDescriptor *> fields;
+    for (const auto &operation : operations) {
+        const gp::FieldDescriptor *field_desc = nullptr;
+        if (!operation.path.empty()) {
+            // Field name might be followed by an array predicate or a map key, e.g. arr[id=1].
+            const auto &field = operation.path.fields().front();
+            auto name = field.substr(0, field.find('['));
+            if (!name.empty() && name.front() == '#') {
+                auto number = util::try_sv_to_int32(StringView(name.data() + 1, name.size() - 1));
+                if (number) {
+                    field_desc = desc->FindFieldByNumber(*number);
+                }
+            } else {
+                field_desc = desc->FindFieldByName(name);
+            }
+        }
+
+        if (field_desc == nullptr) {
+            // The operation modifies the whole message, or the path is invalid,
+            // and the operation fails anyway.
+            fields.clear();
+            for (auto idx = 0; idx != desc->field_count(); ++idx) {
+                fields.push_back(desc->field(idx));
+            }
+
+            return fields;
+        }
+
+        if (std::find(fields.begin(), fields.end(), field_desc) == fields.end()) {
+            fields.push_back(field_desc);
+        }
+    }
+
+    return fields;
+}
+
+void PatchCommand::_apply(gp::Message &msg, const std::vector<Operation> &operations) const {
+    auto &element_index = RedisProtobuf::instance().element_index();
+    for (std::size_t idx = 0; idx != operations.size(); ++idx) {
+        // Previous operations might have moved array elements.
+        element_index.invalidate(&msg);
+
+        try {
+            _apply(msg, operations[idx]);
+        } catch (const Error &e) {
+            throw Error("operation " + std::to_string(idx) + " failed: " + e.what());
+        }
+    }
+}
+
+void PatchCommand::_apply(gp::Message &msg, const Operation &operation) const {
+    if (operation.op == Operation::Op::REMOVE) {
+        DelCommand del_cmd;
+        del_cmd._del(msg, operation.path);
+
+        return;
+    }
+
+    MutableFieldRef field(&msg, operation.path);
+    switch (operation.op) {
+    case Operation::Op::ADD:
+        if (field.is_array() && !field.is_map() && !field.is_array_element()) {
+            // Add to the whole array, i.e. append.
+            AppendCommand append_cmd;
+            append_cmd._append(field, {StringView(operation.value)});
+            break;
+        }
+
+        // Otherwise, it's the same as replace.
+        // fall through
+
+    case Operation::Op::REPLACE: {
+        SetCommand set_cmd;
+        set_cmd._set_field(field, operation.value);
+        break;
+    }
+
+    case Operation::Op::INCREMENT: {
+        IncrbyCommand::Args args;
+        auto type = value_type(field);
+        args.is_float = type == gp::FieldDescriptor::CPPTYPE_DOUBLE
+            || type == gp::FieldDescriptor::CPPTYPE_FLOAT;
+        args.increment = operation.value;
+
+        IncrbyCommand incrby_cmd;
+        incrby_cmd._incr(field, args);
+        break;
+    }
+
+    case Operation::Op::APPEND: {
+        AppendCommand append_cmd;
+        append_cmd._append(field, {StringView(operation.value)});
+        break;
+    }
+
+    default:
+        assert(false);
+    }
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,105 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_PATCH_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_PATCH_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include <vector>
+#include <google/protobuf/struct.pb.h>
+#include "utils.h"
+#include "field_ref.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.PATCH key type patch
+// patch:   JSON array of operations in JSON Patch (RFC 6902) style, e.g.
+//          [{"op" : "replace", "path" : "/i", "value" : 1}, {"op" : "remove", "path" : "/arr/0"}].
+//          Supported ops are add, replace, remove, increment and append.
+// return:  Integer reply: the number of applied operations. If the key doesn't exist,
+//          the patch is applied to an empty message.
+// error:   If the patch is invalid, or any operation fails, or type mismatch,
+//          return an error reply, and the message is not modified.
+class PatchCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Operation {
+        enum class Op {
+            ADD = 0,
+            REPLACE,
+            REMOVE,
+            INCREMENT,
+            APPEND
+        };
+
+        Op op;
+
+        Path path;
+
+        std::string value;
+    };
+
+    struct Args {
+        RedisModuleString *key_name;
+
+        std::string type;
+
+        std::vector<Operation> operations;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    std::vector<Operation> _parse_patch(const std::string &type, const StringView &patch) const;
+
+    // Return the raw JSON text of the value of each operation.
+    std::vector<StringView> _raw_values(const StringView &patch) const;
+
+    Operation _parse_operation(const std::string &type,
+            const gp::Value &operation,
+            const StringView &raw_value) const;
+
+    Operation::Op _parse_op(const std::string &op) const;
+
+    std::string _value_to_string(const gp::Value &value, const StringView &raw_value) const;
+
+    void _patch(RedisModuleKey &key, const Args &args) const;
+
+    // Apply operations to a copy of the fields they modify, and throw if any fails.
+    void _validate(gp::Message &msg, const std::vector<Operation> &operations) const;
+
+    // Top level fields modified by the operations.
+    std::vector<const gp::FieldDescriptor *> _modified_fields(const gp::Message &msg,
+            const std::vector<Operation> &operations) const;
+
+    void _apply(gp::Message &msg, const std::vector<Operation> &operations) const;
+
+    void _apply(gp::Message &msg, const Operation &operation) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_PATCH_COMMANDS_H
@@ -0,0 +1,152 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "pop_command.h"
+#include <algorithm>
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int PopCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto key = api::open_key(ctx, args.get_args.key_name, api::KeyMode::WRITEONLY);
+        assert(key);
+
+        if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
+            RedisModule_ReplyWithNull(ctx);
+        } else {
+            auto *msg = api::get_msg_by_key(key.get());
+            assert(msg != nullptr);
+
+            if (_pop(ctx, *msg, args) > 0) {
+                RedisModule_ReplicateVerbatim(ctx);
+            }
+        }
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+PopCommand::Args PopCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc < 4) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.get_args.key_name = argv[1];
+
+    auto pos = get_reply::parse_opts(argv, argc, args.get_args);
+    if (pos + 2 > argc) {
+        throw WrongArityError();
+    }
+
+    args.get_args.path = Path(argv[pos], argv[pos + 1]);
+    pos += 2;
+
+    if (pos < argc) {
+        auto direction = StringView(argv[pos]);
+        if (util::str_case_equal(direction, "LEFT")) {
+            args.left = true;
+            ++pos;
+        } else if (util::str_case_equal(direction, "RIGHT")) {
+            args.left = false;
+            ++pos;
+        }
+    }
+
+    if (pos < argc) {
+        args.count = util::sv_to_int64(argv[pos]);
+        if (args.count < 0) {
+            throw Error("count should be non-negative");
+        }
+
+        ++pos;
+    }
+
+    if (pos != argc) {
+        throw Error("syntax error");
+    }
+
+    return args;
+}
+
+int PopCommand::_pop(RedisModuleCtx *ctx, gp::Message &msg, const Args &args) const {
+    const auto &path = args.get_args.path;
+    if (msg.GetTypeName() != path.type()) {
+        throw Error("type mismatch");
+    }
+
+    // MutableFieldRef throws if the path doesn't exist, e.g. out-of-range index,
+    // so that all errors are reported before we start replying.
+    MutableFieldRef field(&msg, path);
+    if (!field.is_array() || field.is_map() || field.is_array_element() || field.is_array_slice()) {
+        throw Error("not an array");
+    }
+
+    auto format = args.get_args.format;
+
+    get_reply::validate_format(field.type(), format);
+
+    auto size = field.size();
+    if (args.count < 0 && size == 0) {
+        RedisModule_ReplyWithNull(ctx);
+        return 0;
+    }
+
+    auto num = args.count < 0 ? 1 : static_cast<int>(std::min<long long>(args.count, size));
+    auto begin = args.left ? 0 : size - num;
+    auto end = begin + num;
+
+    // Reply before removing the elements. Elements always exist, and the format
+    // has been validated, so that it won't fail in the middle of replying.
+    ConstFieldRef arr(field);
+    if (args.count < 0) {
+        get_reply::reply_with_value(ctx, arr.get_array_element(begin), format);
+    } else {
+        RedisModule_ReplyWithArray(ctx, num);
+        for (auto idx = 0; idx != num; ++idx) {
+            auto pos = args.left ? begin + idx : end - 1 - idx;
+            get_reply::reply_with_value(ctx, arr.get_array_element(pos), format);
+        }
+    }
+
+    field.del_range(begin, end);
+
+    return num;
+}
+
+}
+
+}
+
+}
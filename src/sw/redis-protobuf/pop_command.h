@@ -0,0 +1,66 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_POP_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_POP_COMMANDS_H
+
+#include "module_api.h"
+#include "utils.h"
+#include "field_ref.h"
+#include "get_reply.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.POP key [--FORMAT BINARY|JSON] type path [LEFT|RIGHT] [count]
+// return:  Remove and return elements from the head, i.e. LEFT (the default),
+//          or the tail, i.e. RIGHT, of the array. If count is not specified,
+//          return the popped element, or nil if the array is empty. Otherwise,
+//          return an array reply of at most count popped elements, in the order
+//          that they're popped. If the key doesn't exist, return a nil reply.
+// error:   If the path doesn't exist, or the corresponding field is not an array,
+//          or type mismatch, return an error reply.
+class PopCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        // Only key_name, format and path are used.
+        GetArgs get_args;
+
+        bool left = true;
+
+        // -1, if count is not specified.
+        long long count = -1;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    // Returns the number of popped elements.
+    int _pop(RedisModuleCtx *ctx, gp::Message &msg, const Args &args) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_POP_COMMANDS_H
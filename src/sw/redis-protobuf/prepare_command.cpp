@@ -0,0 +1,159 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "prepare_command.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+#include "field_ref.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int PrepareCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto &ops = prepared_ops();
+
+        auto signature = _signature(argv, argc);
+        auto handle = ops.find(signature);
+        if (handle < 0) {
+            auto op = _parse_args(argv, argc);
+
+            handle = ops.add(ctx, signature, std::move(op));
+        }
+
+        return RedisModule_ReplyWithLongLong(ctx, handle);
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+PreparedOp PrepareCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc < 3) {
+        throw WrongArityError();
+    }
+
+    // The arguments have the same layout as the equivalent command,
+    // except that the key is replaced by the command name.
+    PreparedOp op;
+    op.cmd = _parse_cmd(argv[1]);
+
+    switch (op.cmd) {
+    case PreparedOp::Cmd::GET: {
+        op.get_args = get_reply::parse_args(argv, argc);
+
+        _validate_path(op.get_args.path);
+        for (const auto &path : op.get_args.paths) {
+            _validate_path(path);
+        }
+        break;
+    }
+    case PreparedOp::Cmd::SET: {
+        SetCommand set_cmd;
+        auto pos = set_cmd._parse_opts(argv, argc, op.set_args);
+        op.set_args.path = _parse_path(argv, argc, pos);
+
+        _validate_path(op.set_args.path);
+        break;
+    }
+    case PreparedOp::Cmd::APPEND: {
+        AppendCommand append_cmd;
+        auto pos = append_cmd._parse_opts(argv, argc, op.append_args);
+        if (pos + 2 != argc) {
+            throw WrongArityError();
+        }
+
+        op.append_args.path = _parse_path(argv, argc, pos);
+
+        _validate_path(op.append_args.path);
+        break;
+    }
+    default:
+        assert(false);
+    }
+
+    op.argv.assign(argv + 2, argv + argc);
+
+    return op;
+}
+
+PreparedOp::Cmd PrepareCommand::_parse_cmd(const StringView &cmd) const {
+    if (util::str_case_equal(cmd, "GET")) {
+        return PreparedOp::Cmd::GET;
+    } else if (util::str_case_equal(cmd, "SET")) {
+        return PreparedOp::Cmd::SET;
+    } else if (util::str_case_equal(cmd, "APPEND")) {
+        return PreparedOp::Cmd::APPEND;
+    } else {
+        throw Error("unknown operation: " + std::string(cmd.data(), cmd.size()));
+    }
+}
+
+Path PrepareCommand::_parse_path(RedisModuleString **argv, int argc, int pos) const {
+    if (pos + 1 == argc) {
+        return Path(argv[pos]);
+    } else if (pos + 2 == argc) {
+        return Path(argv[pos], argv[pos + 1]);
+    } else {
+        throw WrongArityError();
+    }
+}
+
+void PrepareCommand::_validate_path(const Path &path) const {
+    auto msg = RedisProtobuf::instance().proto_factory()->create(path.type());
+    assert(msg);
+
+    // Stop at wildcards, missing elements and slices, since the fields after
+    // them cannot be resolved without data.
+    ConstFieldRef field(msg.get(), Path(path.type()));
+    for (const auto &name : path.fields()) {
+        if (name == "*" || field.missing() || field.is_array_slice()) {
+            break;
+        }
+
+        field.descend(name);
+    }
+}
+
+std::string PrepareCommand::_signature(RedisModuleString **argv, int argc) const {
+    // Length-prefix each argument, so that different arguments never
+    // have the same signature.
+    std::string signature;
+    for (auto idx = 1; idx < argc; ++idx) {
+        auto arg = StringView(argv[idx]);
+        signature += std::to_string(arg.size());
+        signature += ':';
+        signature.append(arg.data(), arg.size());
+    }
+
+    return signature;
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,64 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_PREPARE_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_PREPARE_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include "utils.h"
+#include "path.h"
+#include "prepared_ops.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.PREPARE GET [--FORMAT BINARY|JSON] type [path [path ...]]
+//          PB.PREPARE SET [--NX|--XX] [--EX seconds | --PX milliseconds] type [path]
+//          PB.PREPARE APPEND [--PACKED RAW|PROTO] [--MAXLEN n [~]] type path
+// return:  Integer reply: the handle of the prepared operation, which can be
+//          run with PB.EXEC. The handle is derived from the arguments, so the
+//          same operation always has the same handle, even across restarts.
+// error:   If the operation is unknown, or the type doesn't exist, or the path
+//          is invalid, return an error reply.
+class PrepareCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    PreparedOp _parse_args(RedisModuleString **argv, int argc) const;
+
+    PreparedOp::Cmd _parse_cmd(const StringView &cmd) const;
+
+    Path _parse_path(RedisModuleString **argv, int argc, int pos) const;
+
+    // Check that fields in the path exist, so that invalid paths are
+    // reported at preparing time.
+    void _validate_path(const Path &path) const;
+
+    std::string _signature(RedisModuleString **argv, int argc) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_PREPARE_COMMANDS_H
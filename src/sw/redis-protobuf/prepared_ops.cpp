@@ -0,0 +1,117 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "prepared_ops.h"
+#include <cassert>
+#include "errors.h"
+
+namespace {
+
+const std::size_t MAX_PREPARED_OPS = 65536;
+
+}
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+long long PreparedOps::find(const std::string &signature) {
+    auto handle = _hash(signature);
+    auto iter = _handles.find(handle);
+    if (iter == _handles.end()) {
+        return -1;
+    }
+
+    if (iter->second->signature != signature) {
+        throw Error("handle conflicts with another prepared operation");
+    }
+
+    _touch(iter->second);
+
+    return handle;
+}
+
+long long PreparedOps::add(RedisModuleCtx *ctx, const std::string &signature, PreparedOp op) {
+    auto handle = _hash(signature);
+
+    assert(_handles.find(handle) == _handles.end());
+
+    if (_ops.size() >= MAX_PREPARED_OPS) {
+        _evict(ctx);
+    }
+
+    // Keep the arguments alive for replication.
+    for (auto *arg : op.argv) {
+        RedisModule_RetainString(ctx, arg);
+    }
+
+    _ops.push_front(Entry{handle, signature, std::move(op)});
+    _handles.emplace(handle, _ops.begin());
+
+    return handle;
+}
+
+PreparedOp& PreparedOps::get(long long handle) {
+    auto iter = _handles.find(handle);
+    if (iter == _handles.end()) {
+        throw Error("unknown handle");
+    }
+
+    _touch(iter->second);
+
+    return iter->second->op;
+}
+
+long long PreparedOps::_hash(const std::string &signature) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto ch : signature) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ULL;
+    }
+
+    return static_cast<long long>(hash & 0x7fffffffffffffffULL);
+}
+
+void PreparedOps::_touch(EntryList::iterator iter) {
+    // Iterators of std::list are not invalidated by splice.
+    _ops.splice(_ops.begin(), _ops, iter);
+}
+
+void PreparedOps::_evict(RedisModuleCtx *ctx) {
+    assert(!_ops.empty());
+
+    auto &entry = _ops.back();
+    for (auto *arg : entry.op.argv) {
+        RedisModule_FreeString(ctx, arg);
+    }
+
+    _handles.erase(entry.handle);
+    _ops.pop_back();
+}
+
+PreparedOps& prepared_ops() {
+    static PreparedOps ops;
+
+    return ops;
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,109 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_PREPARED_OPS_H
+#define SEWENEW_REDISPROTOBUF_PREPARED_OPS_H
+
+#include "module_api.h"
+#include <list>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "utils.h"
+#include "get_reply.h"
+#include "set_command.h"
+#include "append_command.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// An operation registered with PB.PREPARE. Its type, path and options have
+// been parsed and validated, so that PB.EXEC only needs to fill in the key
+// and values before running it.
+struct PreparedOp {
+    enum class Cmd {
+        GET = 0,
+        SET,
+        APPEND
+    };
+
+    Cmd cmd;
+
+    // Only the one for cmd is used.
+    GetArgs get_args;
+    SetCommand::Args set_args;
+    AppendCommand::Args append_args;
+
+    // Arguments following the key of the equivalent command, i.e. options, type
+    // and path. These strings are retained for replicating the equivalent command.
+    std::vector<RedisModuleString *> argv;
+};
+
+// Registry of prepared operations. A handle is derived from the signature of the
+// operation, so that the same operation has the same handle on every Redis instance,
+// and across restarts. If there are too many operations, the least recently used one
+// is removed, and its handle becomes unknown until it's prepared again.
+class PreparedOps {
+public:
+    // Return the handle of the operation with the given signature,
+    // or -1 if it has not been prepared.
+    long long find(const std::string &signature);
+
+    // Return the handle of the newly added operation. Its arguments are retained,
+    // and released when it's removed.
+    long long add(RedisModuleCtx *ctx, const std::string &signature, PreparedOp op);
+
+    // Throw Error if the handle is unknown.
+    PreparedOp& get(long long handle);
+
+private:
+    struct Entry {
+        long long handle;
+
+        std::string signature;
+
+        PreparedOp op;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // Non-negative 63-bit FNV-1a hash of the signature.
+    long long _hash(const std::string &signature) const;
+
+    // Mark the entry as the most recently used one.
+    void _touch(EntryList::iterator iter);
+
+    void _evict(RedisModuleCtx *ctx);
+
+    // The most recently used one comes first.
+    EntryList _ops;
+
+    std::unordered_map<long long, EntryList::iterator> _handles;
+};
+
+// Commands are run in the main thread, so there's no need to lock it.
+PreparedOps& prepared_ops();
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_PREPARED_OPS_H
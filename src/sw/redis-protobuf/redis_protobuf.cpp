@@ -122,6 +122,12 @@ void* RedisProtobuf::_rdb_load(RedisModuleIO *rdb, int encver) {
             throw Error("failed to parse protobuf of type: " + type);
         }
 
+        // The message might be allocated at the address of a freed one.
+        m.element_index().invalidate(msg.get());
+
+        // We don't know which key the message is loaded to, so let field indexes catch up.
+        m.field_indexes().loaded();
+
         return msg.release();
     } catch (const Error &e) {
         RedisModule_LogIOError(rdb, "warning", e.what());
@@ -173,6 +179,10 @@ void RedisProtobuf::_aof_rewrite(RedisModuleIO *aof, RedisModuleString *key, voi
 void RedisProtobuf::_free_msg(void *value) {
     if (value != nullptr) {
         auto *msg = static_cast<google::protobuf::Message *>(value);
+
+        // NOTE: the message might be freed in a background thread, e.g. FLUSHALL ASYNC,
+        // so we cannot touch any index here. Instead, element indexes are invalidated
+        // when a message is loaded or written, and field indexes never refer to messages.
         delete msg;
     }
 }
@@ -20,6 +20,8 @@
 #include "module_api.h"
 #include "proto_factory.h"
 #include "options.h"
+#include "element_index.h"
+#include "field_index.h"
 
 namespace sw {
 
@@ -61,6 +63,14 @@ public:
         return _proto_factory.get();
     }
 
+    ElementIndex& element_index() {
+        return _element_index;
+    }
+
+    FieldIndexes& field_indexes() {
+        return _field_indexes;
+    }
+
 private:
     RedisProtobuf() = default;
 
@@ -85,6 +95,10 @@ private:
     std::unique_ptr<ProtoFactory> _proto_factory;
 
     Options _options;
+
+    ElementIndex _element_index;
+
+    FieldIndexes _field_indexes;
 };
 
 }
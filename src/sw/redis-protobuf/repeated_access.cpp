@@ -0,0 +1,124 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "repeated_access.h"
+#include <cassert>
+#include <cstdint>
+#include <google/protobuf/generated_message_reflection.h>
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace repeated_access {
+
+template <typename T>
+gp::RepeatedField<T>& mutable_repeated_field(gp::Message &msg, const gp::FieldDescriptor *field) {
+    assert(field != nullptr && field->is_repeated() && !field->is_map());
+    assert(field->cpp_type() != gp::FieldDescriptor::CPPTYPE_STRING
+            && field->cpp_type() != gp::FieldDescriptor::CPPTYPE_MESSAGE);
+
+    // Hacking: the same as how map_access gets the DynamicMapField.
+    const auto *reflection =
+        static_cast<const gp::internal::GeneratedMessageReflection*>(msg.GetReflection());
+
+    return *reflection->MutableRaw<gp::RepeatedField<T>>(&msg, field);
+}
+
+template <typename T>
+const gp::RepeatedField<T>& repeated_field(const gp::Message &msg,
+        const gp::FieldDescriptor *field) {
+    assert(field != nullptr && field->is_repeated() && !field->is_map());
+    assert(field->cpp_type() != gp::FieldDescriptor::CPPTYPE_STRING
+            && field->cpp_type() != gp::FieldDescriptor::CPPTYPE_MESSAGE);
+
+    const auto *reflection =
+        static_cast<const gp::internal::GeneratedMessageReflection*>(msg.GetReflection());
+
+    return reflection->GetRaw<gp::RepeatedField<T>>(msg, field);
+}
+
+template <typename T>
+gp::RepeatedPtrField<T>& mutable_repeated_ptr_field(gp::Message &msg,
+        const gp::FieldDescriptor *field) {
+    assert(field != nullptr && field->is_repeated() && !field->is_map());
+    assert(field->cpp_type() == gp::FieldDescriptor::CPPTYPE_STRING
+            || field->cpp_type() == gp::FieldDescriptor::CPPTYPE_MESSAGE);
+
+    const auto *reflection =
+        static_cast<const gp::internal::GeneratedMessageReflection*>(msg.GetReflection());
+
+    // Protobuf itself only accesses repeated message fields as RepeatedPtrFieldBase,
+    // and RepeatedPtrField<T> adds no data member to the base.
+    auto *base = reflection->MutableRaw<gp::internal::RepeatedPtrFieldBase>(&msg, field);
+
+    return *reinterpret_cast<gp::RepeatedPtrField<T>*>(base);
+}
+
+template gp::RepeatedField<int32_t>& mutable_repeated_field<int32_t>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedField<int64_t>& mutable_repeated_field<int64_t>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedField<uint32_t>& mutable_repeated_field<uint32_t>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedField<uint64_t>& mutable_repeated_field<uint64_t>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedField<float>& mutable_repeated_field<float>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedField<double>& mutable_repeated_field<double>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedField<bool>& mutable_repeated_field<bool>(gp::Message &,
+        const gp::FieldDescriptor *);
+
+template const gp::RepeatedField<int32_t>& repeated_field<int32_t>(const gp::Message &,
+        const gp::FieldDescriptor *);
+
+template const gp::RepeatedField<int64_t>& repeated_field<int64_t>(const gp::Message &,
+        const gp::FieldDescriptor *);
+
+template const gp::RepeatedField<uint32_t>& repeated_field<uint32_t>(const gp::Message &,
+        const gp::FieldDescriptor *);
+
+template const gp::RepeatedField<uint64_t>& repeated_field<uint64_t>(const gp::Message &,
+        const gp::FieldDescriptor *);
+
+template const gp::RepeatedField<float>& repeated_field<float>(const gp::Message &,
+        const gp::FieldDescriptor *);
+
+template const gp::RepeatedField<double>& repeated_field<double>(const gp::Message &,
+        const gp::FieldDescriptor *);
+
+template gp::RepeatedPtrField<std::string>& mutable_repeated_ptr_field<std::string>(
+        gp::Message &, const gp::FieldDescriptor *);
+
+template gp::RepeatedPtrField<gp::Message>& mutable_repeated_ptr_field<gp::Message>(
+        gp::Message &, const gp::FieldDescriptor *);
+
+}
+
+}
+
+}
+
+}
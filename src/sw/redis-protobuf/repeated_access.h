@@ -0,0 +1,63 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_REPEATED_ACCESS_H
+#define SEWENEW_REDISPROTOBUF_REPEATED_ACCESS_H
+
+#include <string>
+#include <google/protobuf/message.h>
+#include <google/protobuf/repeated_field.h>
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// Protobuf reflection only exposes repeated fields element by element, and the
+// RepeatedField accessor is deprecated. In order to reserve capacity and bulk
+// copy numeric elements, we access the underlying RepeatedField directly.
+namespace repeated_access {
+
+namespace gp = google::protobuf;
+
+// Get the RepeatedField of a numeric, i.e. non-string and non-message, repeated field.
+// T should match the C++ type of the field, e.g. int32_t for int32, sint32 and enum.
+// It's explicitly instantiated for int32_t, int64_t, uint32_t, uint64_t, float,
+// double and bool.
+template <typename T>
+gp::RepeatedField<T>& mutable_repeated_field(gp::Message &msg, const gp::FieldDescriptor *field);
+
+// Read-only version of mutable_repeated_field, e.g. for aggregating elements in place.
+template <typename T>
+const gp::RepeatedField<T>& repeated_field(const gp::Message &msg,
+        const gp::FieldDescriptor *field);
+
+// Get the RepeatedPtrField of a string or message repeated field.
+// It's explicitly instantiated for std::string and gp::Message.
+template <typename T>
+gp::RepeatedPtrField<T>& mutable_repeated_ptr_field(gp::Message &msg,
+        const gp::FieldDescriptor *field);
+
+}
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_REPEATED_ACCESS_H
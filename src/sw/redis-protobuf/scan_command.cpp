@@ -0,0 +1,287 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "scan_command.h"
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int ScanCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto reply = _scan_keys(ctx, args);
+        assert(reply);
+
+        // Reply of SCAN: [next cursor, [key1, key2, ...]]
+        auto *cursor_reply = RedisModule_CallReplyArrayElement(reply.get(), 0);
+        auto *keys_reply = RedisModule_CallReplyArrayElement(reply.get(), 1);
+        if (cursor_reply == nullptr || keys_reply == nullptr) {
+            throw Error("invalid scan reply");
+        }
+
+        std::size_t len = 0;
+        const auto *ptr = RedisModule_CallReplyStringPtr(cursor_reply, &len);
+        std::string cursor(ptr, len);
+
+        auto &m = RedisProtobuf::instance();
+
+        // Evaluate all keys before replying, so that we can reply with an error
+        // if something goes wrong, instead of a partial reply.
+        std::vector<Match> matches;
+        auto num = RedisModule_CallReplyLength(keys_reply);
+        for (std::size_t idx = 0; idx != num; ++idx) {
+            auto *key_reply = RedisModule_CallReplyArrayElement(keys_reply, idx);
+            api::RedisString key_name(RedisModule_CreateStringFromCallReply(key_reply),
+                    api::RedisStringDeleter(ctx));
+            if (!key_name) {
+                continue;
+            }
+
+            auto key = api::open_key(ctx, key_name.get(), api::KeyMode::READONLY);
+
+            // Skip keys of other types, instead of returning a WRONGTYPE error.
+            if (RedisModule_KeyType(key.get()) != REDISMODULE_KEYTYPE_MODULE
+                    || RedisModule_ModuleTypeGetType(key.get()) != m.type()) {
+                continue;
+            }
+
+            const auto *msg = api::get_msg_by_key(key.get());
+            assert(msg != nullptr);
+
+            if (!_match(*msg, args)) {
+                continue;
+            }
+
+            matches.push_back(Match{std::move(key_name), std::move(key), msg});
+        }
+
+        _reply(ctx, cursor, matches, args);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+}
+
+ScanCommand::Args ScanCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc < 3) {
+        throw WrongArityError();
+    }
+
+    Args args;
+
+    auto pos = get_reply::parse_opts(argv, argc, args.get_args, 1);
+    if (args.get_args.masked) {
+        throw Error("--MASK is not supported");
+    }
+
+    if (pos + 2 > argc) {
+        throw WrongArityError();
+    }
+
+    args.cursor = argv[pos];
+    args.type = util::sv_to_string(argv[pos + 1]);
+    if (RedisProtobuf::instance().proto_factory()->descriptor(args.type) == nullptr) {
+        throw Error("unknown type: " + args.type);
+    }
+
+    args.get_args.path = Path(StringView(args.type));
+
+    _parse_scan_opts(argv, argc, pos + 2, args);
+
+    _validate_conditions(args);
+
+    return args;
+}
+
+void ScanCommand::_parse_scan_opts(RedisModuleString **argv,
+        int argc,
+        int pos,
+        Args &args) const {
+    auto idx = pos;
+    while (idx < argc) {
+        auto opt = StringView(argv[idx]);
+        if (util::str_case_equal(opt, "WHERE")) {
+            idx = _parse_conditions(argv, argc, idx + 1, args);
+            continue;
+        } else if (util::str_case_equal(opt, "RETURN")) {
+            idx = _parse_returns(argv, argc, idx + 1, args);
+            continue;
+        }
+
+        if (idx + 1 >= argc) {
+            throw Error("syntax error");
+        }
+
+        if (util::str_case_equal(opt, "COUNT")) {
+            try {
+                args.count = util::sv_to_int64(argv[idx + 1]);
+            } catch (const Error &) {
+                throw Error("invalid count");
+            }
+
+            if (args.count < 1) {
+                throw Error("syntax error");
+            }
+        } else if (util::str_case_equal(opt, "MATCH")) {
+            args.pattern = Optional<std::string>(util::sv_to_string(argv[idx + 1]));
+        } else {
+            throw Error("syntax error");
+        }
+
+        idx += 2;
+    }
+}
+
+int ScanCommand::_parse_conditions(RedisModuleString **argv,
+        int argc,
+        int pos,
+        Args &args) const {
+    if (pos >= argc || !_is_path(argv[pos])) {
+        throw Error("syntax error");
+    }
+
+    while (pos < argc && _is_path(argv[pos])) {
+        Condition condition;
+        pos = condition.parse(argv, argc, pos);
+        args.conditions.push_back(std::move(condition));
+    }
+
+    return pos;
+}
+
+int ScanCommand::_parse_returns(RedisModuleString **argv,
+        int argc,
+        int pos,
+        Args &args) const {
+    if (pos >= argc || !_is_path(argv[pos])) {
+        throw Error("syntax error");
+    }
+
+    auto &paths = args.get_args.paths;
+    while (pos < argc && _is_path(argv[pos])) {
+        paths.emplace_back(StringView(args.type), argv[pos]);
+        ++pos;
+    }
+
+    return pos;
+}
+
+bool ScanCommand::_is_path(RedisModuleString *arg) const {
+    auto sv = StringView(arg);
+
+    return sv.size() > 0 && *(sv.data()) == '/';
+}
+
+void ScanCommand::_validate_conditions(const Args &args) const {
+    if (args.conditions.empty()) {
+        return;
+    }
+
+    auto msg = RedisProtobuf::instance().proto_factory()->create(args.type);
+    assert(msg);
+
+    for (const auto &condition : args.conditions) {
+        condition.eval(*msg);
+    }
+}
+
+api::CallReply ScanCommand::_scan_keys(RedisModuleCtx *ctx, const Args &args) const {
+    api::CallReply reply;
+    if (args.pattern) {
+        reply.reset(RedisModule_Call(ctx, "SCAN", "sclcc",
+                    args.cursor, "COUNT", args.count, "MATCH", args.pattern->c_str()));
+    } else {
+        reply.reset(RedisModule_Call(ctx, "SCAN", "scl", args.cursor, "COUNT", args.count));
+    }
+
+    if (!reply) {
+        throw Error("failed to scan keys");
+    }
+
+    auto type = RedisModule_CallReplyType(reply.get());
+    if (type == REDISMODULE_REPLY_ERROR) {
+        std::size_t len = 0;
+        const auto *ptr = RedisModule_CallReplyStringPtr(reply.get(), &len);
+        auto err = std::string(ptr, len);
+        // Strip the error prefix, since it will be added when replying with error.
+        if (err.compare(0, 4, "ERR ") == 0) {
+            err = err.substr(4);
+        }
+
+        throw Error(err);
+    }
+
+    if (type != REDISMODULE_REPLY_ARRAY || RedisModule_CallReplyLength(reply.get()) != 2) {
+        throw Error("invalid scan reply");
+    }
+
+    return reply;
+}
+
+bool ScanCommand::_match(const gp::Message &msg, const Args &args) const {
+    if (msg.GetTypeName() != args.type) {
+        return false;
+    }
+
+    for (const auto &condition : args.conditions) {
+        if (!condition.eval(msg)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ScanCommand::_reply(RedisModuleCtx *ctx,
+        const std::string &cursor,
+        const std::vector<Match> &matches,
+        const Args &args) const {
+    RedisModule_ReplyWithArray(ctx, 2);
+
+    RedisModule_ReplyWithStringBuffer(ctx, cursor.data(), cursor.size());
+
+    RedisModule_ReplyWithArray(ctx, matches.size());
+
+    for (const auto &match : matches) {
+        if (args.get_args.paths.empty()) {
+            RedisModule_ReplyWithString(ctx, match.key_name.get());
+            continue;
+        }
+
+        RedisModule_ReplyWithArray(ctx, 2);
+        RedisModule_ReplyWithString(ctx, match.key_name.get());
+        get_reply::reply_with_fields(ctx, *match.msg, args.get_args);
+    }
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,105 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_SCAN_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_SCAN_COMMANDS_H
+
+#include "module_api.h"
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "condition.h"
+#include "get_reply.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.SCAN [--FORMAT BINARY|JSON] cursor type [MATCH pattern]
+//              [WHERE path op [value] [path op [value] ...]] [RETURN path [path ...]]
+//              [COUNT count]
+// return:  Array reply: the first item is the next cursor as a bulk string reply,
+//          and "0" means the iteration is finished. The second item is an array
+//          reply of the scanned keys, whose messages are of *type*, and satisfy
+//          all conditions. If RETURN is specified, each item is an array reply of
+//          the key and the values of the paths, which are replied in the same way
+//          as PB.GET with multiple paths.
+// error:   If the type doesn't exist, or a condition is invalid, or the cursor is
+//          invalid, return an error reply.
+class ScanCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        RedisModuleString *cursor;
+
+        std::string type;
+
+        Optional<std::string> pattern;
+
+        // All conditions should be satisfied.
+        std::vector<Condition> conditions;
+
+        // Format, root path and RETURN paths to reply in the same way as PB.GET.
+        GetArgs get_args;
+
+        long long count = 10;
+    };
+
+    struct Match {
+        api::RedisString key_name;
+
+        api::RedisKey key;
+
+        const gp::Message *msg;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    void _parse_scan_opts(RedisModuleString **argv, int argc, int pos, Args &args) const;
+
+    // Parse arguments beginning with /, i.e. paths, from argv[pos],
+    // and return the position of the first non-path argument.
+    int _parse_conditions(RedisModuleString **argv, int argc, int pos, Args &args) const;
+
+    int _parse_returns(RedisModuleString **argv, int argc, int pos, Args &args) const;
+
+    bool _is_path(RedisModuleString *arg) const;
+
+    // Evaluate conditions on an empty message, so that invalid conditions, e.g.
+    // non-existent fields, fail the command, before scanning any key.
+    void _validate_conditions(const Args &args) const;
+
+    api::CallReply _scan_keys(RedisModuleCtx *ctx, const Args &args) const;
+
+    bool _match(const gp::Message &msg, const Args &args) const;
+
+    void _reply(RedisModuleCtx *ctx,
+            const std::string &cursor,
+            const std::vector<Match> &matches,
+            const Args &args) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_SCAN_COMMANDS_H
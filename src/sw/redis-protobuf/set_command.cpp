@@ -19,6 +19,25 @@
 #include "redis_protobuf.h"
 #include "utils.h"
 #include "field_ref.h"
+#include "field_type.h"
+
+namespace {
+
+using sw::redis::pb::gp::FieldDescriptor;
+using sw::redis::pb::FieldAccess;
+using sw::redis::pb::FieldKind;
+using sw::redis::pb::FieldType;
+using sw::redis::pb::MutableFieldRef;
+using sw::redis::pb::StringView;
+
+template <FieldDescriptor::CppType T, FieldKind K>
+struct SetHandler {
+    static void run(MutableFieldRef &field, const StringView &sv) {
+        FieldAccess<T, K>::set(field, FieldType<T>::parse(field, sv));
+    }
+};
+
+}
 
 namespace sw {
 
@@ -47,22 +66,30 @@ int SetCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) con
 int SetCommand::_run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
     assert(ctx != nullptr);
 
+    auto args = _parse_args(argv, argc);
+
+    return _run(ctx, args);
+}
+
+int SetCommand::_run(RedisModuleCtx *ctx, const Args &args) const {
+    assert(ctx != nullptr);
+
     // TODO: if the ByteSize is too large, serialization might fail.
 
-    auto args = _parse_args(argv, argc);
     const auto &path = args.path;
 
     auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
     assert(key);
 
     if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
-        if (args.opt == Args::Opt::XX) {
+        if (args.opt == Args::Opt::XX || !_check_condition(args, nullptr)) {
             return 0;
         }
 
         _create_msg(*key, path, args.val);
     } else {
-        if (args.opt == Args::Opt::NX) {
+        if (args.opt == Args::Opt::NX
+                || !_check_condition(args, api::get_msg_by_key(key.get()))) {
             return 0;
         }
 
@@ -108,8 +135,8 @@ SetCommand::Args SetCommand::_parse_args(RedisModuleString **argv, int argc) con
     return args;
 }
 
-int SetCommand::_parse_opts(RedisModuleString **argv, int argc, Args &args) const {
-    auto idx = 2;
+int SetCommand::_parse_opts(RedisModuleString **argv, int argc, Args &args, int pos) const {
+    auto idx = pos;
     while (idx < argc) {
         auto opt = StringView(argv[idx]);
 
@@ -145,6 +172,14 @@ int SetCommand::_parse_opts(RedisModuleString **argv, int argc, Args &args) cons
 
             auto expire = _parse_expire(argv[idx]);
             args.expire = std::chrono::milliseconds(expire);
+        } else if (util::str_case_equal(opt, "--IF")) {
+            if (!args.condition.empty()) {
+                throw Error("syntax error");
+            }
+
+            // NOTE: the condition has variable number of arguments,
+            // so move idx to its last argument.
+            idx = args.condition.parse(argv, argc, idx + 1) - 1;
         } else {
             // Finish parsing options.
             break;
@@ -165,6 +200,27 @@ int64_t SetCommand::_parse_expire(const StringView &sv) const {
     return expire;
 }
 
+bool SetCommand::_check_condition(const Args &args, const gp::Message *msg) const {
+    const auto &condition = args.condition;
+    if (condition.empty()) {
+        return true;
+    }
+
+    if (msg == nullptr) {
+        // Key doesn't exist, evaluate it on an empty message.
+        auto empty_msg = RedisProtobuf::instance().proto_factory()->create(args.path.type());
+        assert(empty_msg);
+
+        return condition.eval(*empty_msg);
+    }
+
+    if (msg->GetTypeName() != args.path.type()) {
+        throw Error("type mismatch");
+    }
+
+    return condition.eval(*msg);
+}
+
 void SetCommand::_create_msg(RedisModuleKey &key,
         const Path &path,
         const StringView &val) const {
@@ -212,371 +268,15 @@ void SetCommand::_set_msg(RedisModuleKey &key,
 }
 
 void SetCommand::_set_field(MutableFieldRef &field, const StringView &val) const {
-    if (field.is_map_element()) {
-        return _set_map_element(field, val);
-    } else if (field.is_map()) {
+    if (field.is_map() && !field.is_map_element()) {
         throw Error("cannot set the whole map field");
-    } else if (field.is_array_element()) {
-        return _set_array_element(field, val);
-    } else if (field.is_array()) {
+    } else if (field.is_array() && !field.is_array_element()) {
         throw Error("cannot set the whole array field");
     }
 
-    _set_scalar_field(field, val);
-}
-
-void SetCommand::_set_scalar_field(MutableFieldRef &field, const StringView &val) const {
-    switch (field.type()) {
-    case gp::FieldDescriptor::CPPTYPE_INT32:
-        _set_int32(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_INT64:
-        _set_int64(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_UINT32:
-        _set_uint32(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_UINT64:
-        _set_uint64(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
-        _set_double(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_FLOAT:
-        _set_float(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_BOOL:
-        _set_bool(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_ENUM:
-        _set_enum(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_STRING:
-        _set_string(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_MESSAGE:
-        _set_msg(field, val);
-        break;
-
-    default:
-        throw Error("unknown type");
-    }
-}
-
-void SetCommand::_set_map_element(MutableFieldRef &field, const StringView &val) const {
-    switch (field.map_value_type()) {
-    case gp::FieldDescriptor::CPPTYPE_INT32:
-        _set_mapped_int32(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_INT64:
-        _set_mapped_int64(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_UINT32:
-        _set_mapped_uint32(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_UINT64:
-        _set_mapped_uint64(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
-        _set_mapped_double(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_FLOAT:
-        _set_mapped_float(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_BOOL:
-        _set_mapped_bool(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_ENUM:
-        _set_mapped_enum(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_STRING:
-        _set_mapped_string(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_MESSAGE:
-        _set_mapped_msg(field, val);
-        break;
-
-    default:
-        throw Error("unknown type");
-    }
-}
-
-void SetCommand::_set_array_element(MutableFieldRef &field, const StringView &val) const {
-    switch (field.type()) {
-    case gp::FieldDescriptor::CPPTYPE_INT32:
-        _set_repeated_int32(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_INT64:
-        _set_repeated_int64(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_UINT32:
-        _set_repeated_uint32(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_UINT64:
-        _set_repeated_uint64(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_DOUBLE:
-        _set_repeated_double(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_FLOAT:
-        _set_repeated_float(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_BOOL:
-        _set_repeated_bool(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_ENUM:
-        _set_repeated_enum(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_STRING:
-        _set_repeated_string(field, val);
-        break;
-
-    case gp::FieldDescriptor::CPPTYPE_MESSAGE:
-        _set_repeated_msg(field, val);
-        break;
-
-    default:
-        throw Error("unknown type");
-    }
-}
-
-void SetCommand::_set_int32(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_INT32);
-
-    auto val = util::sv_to_int32(sv);
-    field.set_int32(val);
-}
-
-void SetCommand::_set_int64(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_INT64);
-
-    auto val = util::sv_to_int64(sv);
-    field.set_int64(val);
-}
-
-void SetCommand::_set_uint32(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_UINT32);
-
-    auto val = util::sv_to_uint32(sv);
-    field.set_uint32(val);
-}
-
-void SetCommand::_set_uint64(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_UINT64);
-
-    auto val = util::sv_to_uint64(sv);
-    field.set_uint64(val);
-}
-
-void SetCommand::_set_double(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_DOUBLE);
-
-    auto val = util::sv_to_double(sv);
-    field.set_double(val);
-}
-
-void SetCommand::_set_float(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_FLOAT);
-
-    auto val = util::sv_to_float(sv);
-    field.set_float(val);
-}
-
-void SetCommand::_set_bool(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_BOOL);
-
-    auto val = util::sv_to_bool(sv);
-    field.set_bool(val);
-}
-
-void SetCommand::_set_enum(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_ENUM);
-
-    auto val = util::sv_to_int32(sv);
-    field.set_enum(val);
-}
-
-void SetCommand::_set_string(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_STRING);
-
-    field.set_string(util::sv_to_string(sv));
-}
-
-void SetCommand::_set_msg(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_MESSAGE);
-
-    auto new_msg = RedisProtobuf::instance().proto_factory()->create(field.msg_type(), sv);
-    assert(new_msg);
-
-    field.set_msg(*new_msg);
-}
-
-void SetCommand::_set_repeated_int32(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_INT32);
-
-    auto val = util::sv_to_int32(sv);
-    field.set_repeated_int32(val);
-}
-
-void SetCommand::_set_repeated_int64(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_INT64);
-
-    auto val = util::sv_to_int64(sv);
-    field.set_repeated_int64(val);
-}
-
-void SetCommand::_set_repeated_uint32(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_UINT32);
-
-    auto val = util::sv_to_uint32(sv);
-    field.set_repeated_uint32(val);
-}
-
-void SetCommand::_set_repeated_uint64(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_UINT64);
-
-    auto val = util::sv_to_uint64(sv);
-    field.set_repeated_uint64(val);
-}
-
-void SetCommand::_set_repeated_double(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_DOUBLE);
-
-    auto val = util::sv_to_double(sv);
-    field.set_repeated_double(val);
-}
-
-void SetCommand::_set_repeated_float(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_FLOAT);
-
-    auto val = util::sv_to_float(sv);
-    field.set_repeated_float(val);
-}
-
-void SetCommand::_set_repeated_bool(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_BOOL);
-
-    auto val = util::sv_to_bool(sv);
-    field.set_repeated_bool(val);
-}
-
-void SetCommand::_set_repeated_enum(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_ENUM);
-
-    auto val = util::sv_to_int32(sv);
-    field.set_repeated_enum(val);
-}
-
-void SetCommand::_set_repeated_string(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_STRING);
-
-    field.set_repeated_string(util::sv_to_string(sv));
-}
-
-void SetCommand::_set_repeated_msg(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.type() == gp::FieldDescriptor::CPPTYPE_MESSAGE);
-
-    auto new_msg = RedisProtobuf::instance().proto_factory()->create(field.msg_type(), sv);
-    assert(new_msg);
-
-    field.set_repeated_msg(*new_msg);
-}
-
-void SetCommand::_set_mapped_int32(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_INT32);
-
-    auto val = util::sv_to_int32(sv);
-    field.set_mapped_int32(val);
-}
-
-void SetCommand::_set_mapped_int64(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_INT64);
-
-    auto val = util::sv_to_int64(sv);
-    field.set_mapped_int64(val);
-}
-
-void SetCommand::_set_mapped_uint32(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_UINT32);
-
-    auto val = util::sv_to_uint32(sv);
-    field.set_mapped_uint32(val);
-}
-
-void SetCommand::_set_mapped_uint64(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_UINT64);
-
-    auto val = util::sv_to_uint64(sv);
-    field.set_mapped_uint64(val);
-}
-
-void SetCommand::_set_mapped_double(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_DOUBLE);
-
-    auto val = util::sv_to_double(sv);
-    field.set_mapped_double(val);
-}
-
-void SetCommand::_set_mapped_float(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_FLOAT);
-
-    auto val = util::sv_to_float(sv);
-    field.set_mapped_float(val);
-}
-
-void SetCommand::_set_mapped_bool(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_BOOL);
-
-    auto val = util::sv_to_bool(sv);
-    field.set_mapped_bool(val);
-}
-
-void SetCommand::_set_mapped_enum(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_ENUM);
-
-    auto val = util::sv_to_int32(sv);
-    field.set_mapped_enum(val);
-}
-
-void SetCommand::_set_mapped_string(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_STRING);
-
-    field.set_mapped_string(util::sv_to_string(sv));
-}
-
-void SetCommand::_set_mapped_msg(MutableFieldRef &field, const StringView &sv) const {
-    assert(field.map_value_type() == gp::FieldDescriptor::CPPTYPE_MESSAGE);
-
-    auto new_msg = RedisProtobuf::instance().proto_factory()->create(field.mapped_msg_type(), sv);
-    assert(new_msg);
+    static const DispatchTable<SetHandler, void (*)(MutableFieldRef &, const StringView &)> table;
 
-    field.set_mapped_msg(*new_msg);
+    table.get(field)(field, val);
 }
 
 }
@@ -23,6 +23,7 @@
 #include <chrono>
 #include "utils.h"
 #include "field_ref.h"
+#include "condition.h"
 
 namespace sw {
 
@@ -30,9 +31,11 @@ namespace redis {
 
 namespace pb {
 
-// command: PB.SET key [--NX|--XX] [--EX seconds | --PX milliseconds] type [path] value
+// command: PB.SET key [--NX|--XX] [--EX seconds | --PX milliseconds]
+//              [--IF path op [value]] type [path] value
 // return:  Integer reply: 1 if set successfully. 0, otherwise, e.g. option --NX has
-//          been set, while key already exists.
+//          been set, while key already exists, or the condition of --IF is false.
+//          If key doesn't exist, the condition is evaluated on an empty message.
 // error:   If the type doesn't match the protobuf message type of the
 //          key, or the path doesn't exist, return an error reply.
 class SetCommand {
@@ -53,21 +56,34 @@ private:
 
         std::chrono::milliseconds expire{0};
 
+        // Only set if the condition is true.
+        Condition condition;
+
         Path path;
         StringView val;
     };
 
     int _run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
 
+    int _run(RedisModuleCtx *ctx, const Args &args) const;
+
     friend class MergeCommand;
+    friend class MSetCommand;
+    friend class PatchCommand;
+    friend class PrepareCommand;
+    friend class ExecCommand;
+    friend struct PreparedOp;
 
     Args _parse_args(RedisModuleString **argv, int argc) const;
 
-    // Return the position of the first non-option argument.
-    int _parse_opts(RedisModuleString **argv, int argc, Args &args) const;
+    // Parse options starting from argv[pos], and return the position of the
+    // first non-option argument.
+    int _parse_opts(RedisModuleString **argv, int argc, Args &args, int pos = 2) const;
 
     int64_t _parse_expire(const StringView &sv) const;
 
+    bool _check_condition(const Args &args, const gp::Message *msg) const;
+
     void _create_msg(RedisModuleKey &key,
             const Path &path,
             const StringView &val) const;
@@ -76,73 +92,7 @@ private:
             const Path &path,
             const StringView &val) const;
 
-    void _set_scalar_field(MutableFieldRef &field, const StringView &val) const;
-
-    void _set_map_element(MutableFieldRef &field, const StringView &val) const;
-
-    void _set_array_element(MutableFieldRef &field, const StringView &val) const;
-
     void _set_field(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_int32(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_int64(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_uint32(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_uint64(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_double(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_float(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_bool(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_enum(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_string(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_msg(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_int32(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_int64(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_uint32(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_uint64(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_double(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_float(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_bool(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_enum(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_string(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_repeated_msg(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_int32(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_int64(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_uint32(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_uint64(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_double(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_float(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_bool(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_enum(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_string(MutableFieldRef &field, const StringView &sv) const;
-
-    void _set_mapped_msg(MutableFieldRef &field, const StringView &sv) const;
 };
 
 }
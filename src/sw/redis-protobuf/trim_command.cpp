@@ -0,0 +1,111 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "trim_command.h"
+#include <algorithm>
+#include "errors.h"
+#include "redis_protobuf.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+int TrimCommand::run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const {
+    try {
+        assert(ctx != nullptr);
+
+        auto args = _parse_args(argv, argc);
+
+        auto key = api::open_key(ctx, args.key_name, api::KeyMode::WRITEONLY);
+        assert(key);
+
+        if (!api::key_exists(key.get(), RedisProtobuf::instance().type())) {
+            RedisModule_ReplyWithLongLong(ctx, 0);
+        } else {
+            auto *msg = api::get_msg_by_key(key.get());
+            assert(msg != nullptr);
+
+            auto len = _trim(*msg, args);
+
+            RedisModule_ReplyWithLongLong(ctx, len);
+        }
+
+        RedisModule_ReplicateVerbatim(ctx);
+
+        return REDISMODULE_OK;
+    } catch (const WrongArityError &err) {
+        return RedisModule_WrongArity(ctx);
+    } catch (const Error &err) {
+        return api::reply_with_error(ctx, err);
+    }
+
+    return REDISMODULE_ERR;
+}
+
+TrimCommand::Args TrimCommand::_parse_args(RedisModuleString **argv, int argc) const {
+    assert(argv != nullptr);
+
+    if (argc != 6) {
+        throw WrongArityError();
+    }
+
+    Args args;
+    args.key_name = argv[1];
+    args.path = Path(argv[2], argv[3]);
+    args.start = util::sv_to_int64(argv[4]);
+    args.stop = util::sv_to_int64(argv[5]);
+
+    return args;
+}
+
+long long TrimCommand::_trim(gp::Message &msg, const Args &args) const {
+    if (msg.GetTypeName() != args.path.type()) {
+        throw Error("type mismatch");
+    }
+
+    MutableFieldRef field(&msg, args.path);
+    if (!field.is_array() || field.is_map() || field.is_array_element() || field.is_array_slice()) {
+        throw Error("not an array");
+    }
+
+    long long size = field.size();
+
+    auto start = args.start < 0 ? args.start + size : args.start;
+    auto stop = args.stop < 0 ? args.stop + size : args.stop;
+    start = std::max(start, 0LL);
+    stop = std::min(stop, size - 1);
+
+    if (start > stop) {
+        // Empty range, remove all elements.
+        field.del_range(0, static_cast<int>(size));
+
+        return 0;
+    }
+
+    // Remove the tail first, so that there're fewer elements to move when removing the head.
+    field.del_range(static_cast<int>(stop + 1), static_cast<int>(size));
+    field.del_range(0, static_cast<int>(start));
+
+    return stop - start + 1;
+}
+
+}
+
+}
+
+}
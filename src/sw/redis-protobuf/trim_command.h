@@ -0,0 +1,59 @@
+/**************************************************************************
+   Copyright (c) 2019 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef SEWENEW_REDISPROTOBUF_TRIM_COMMANDS_H
+#define SEWENEW_REDISPROTOBUF_TRIM_COMMANDS_H
+
+#include "module_api.h"
+#include "utils.h"
+#include "field_ref.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+// command: PB.TRIM key type path start stop
+// return:  Integer reply: the size of the array after trimming, i.e. only elements
+//          in [start, stop], both inclusive, are kept. Negative indexes count from
+//          the end of the array. If the key doesn't exist, return 0.
+// error:   If the path doesn't exist, or the corresponding field is not an array,
+//          or type mismatch, return an error reply.
+class TrimCommand {
+public:
+    int run(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) const;
+
+private:
+    struct Args {
+        RedisModuleString *key_name;
+        Path path;
+        long long start;
+        long long stop;
+    };
+
+    Args _parse_args(RedisModuleString **argv, int argc) const;
+
+    long long _trim(gp::Message &msg, const Args &args) const;
+};
+
+}
+
+}
+
+}
+
+#endif // end SEWENEW_REDISPROTOBUF_TRIM_COMMANDS_H
@@ -20,6 +20,10 @@
 #include <dirent.h>
 #include <cassert>
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
 #include <google/protobuf/util/json_util.h>
 #include "errors.h"
 
@@ -27,6 +31,28 @@ namespace {
 
 mode_t file_type(const std::string &file);
 
+using sw::redis::pb::Optional;
+using sw::redis::pb::StringView;
+
+// Parse number with strto* function, and the whole string should be consumed.
+template <typename Func>
+auto parse_number(const StringView &sv, Func func)
+    -> Optional<decltype(func(nullptr, nullptr))>;
+
+// Check if *sv* looks like a decimal number. strto* functions also accept leading
+// whitespaces, a leading '+', hex numbers, and nan or inf, which we don't allow.
+bool is_decimal(const StringView &sv);
+
+bool is_negative(const StringView &sv);
+
+long long strtoll_10(const char *str, char **end) {
+    return std::strtoll(str, end, 10);
+}
+
+unsigned long long strtoull_10(const char *str, char **end) {
+    return std::strtoull(str, end, 10);
+}
+
 }
 
 namespace sw {
@@ -55,83 +81,237 @@ std::string msg_to_json(const gp::Message &msg) {
     return json;
 }
 
+Optional<int32_t> try_sv_to_int32(const StringView &sv) {
+    auto val = parse_number(sv, strtoll_10);
+    if (!val || *val < std::numeric_limits<int32_t>::min()
+            || *val > std::numeric_limits<int32_t>::max()) {
+        return {};
+    }
+
+    return Optional<int32_t>(*val);
+}
+
+Optional<int64_t> try_sv_to_int64(const StringView &sv) {
+    auto val = parse_number(sv, strtoll_10);
+    if (!val) {
+        return {};
+    }
+
+    return Optional<int64_t>(*val);
+}
+
+Optional<uint32_t> try_sv_to_uint32(const StringView &sv) {
+    if (is_negative(sv)) {
+        return {};
+    }
+
+    auto val = parse_number(sv, strtoull_10);
+    if (!val || *val > std::numeric_limits<uint32_t>::max()) {
+        return {};
+    }
+
+    return Optional<uint32_t>(*val);
+}
+
+Optional<uint64_t> try_sv_to_uint64(const StringView &sv) {
+    if (is_negative(sv)) {
+        return {};
+    }
+
+    auto val = parse_number(sv, strtoull_10);
+    if (!val) {
+        return {};
+    }
+
+    return Optional<uint64_t>(*val);
+}
+
+Optional<double> try_sv_to_double(const StringView &sv) {
+    return parse_number(sv, std::strtod);
+}
+
+Optional<float> try_sv_to_float(const StringView &sv) {
+    return parse_number(sv, std::strtof);
+}
+
+Optional<bool> try_sv_to_bool(const StringView &sv) {
+    // TODO: make it case insensitive
+    if (sv.size() == 4 && std::memcmp(sv.data(), "true", 4) == 0) {
+        return Optional<bool>(true);
+    } else if (sv.size() == 5 && std::memcmp(sv.data(), "false", 5) == 0) {
+        return Optional<bool>(false);
+    }
+
+    auto val = try_sv_to_int32(sv);
+    if (!val) {
+        return {};
+    }
+
+    return Optional<bool>(*val != 0);
+}
+
 int32_t sv_to_int32(const StringView &sv) {
-    try {
-        return std::stoi(std::string(sv.data(), sv.size()));
-    } catch (const std::exception &e) {
+    auto val = try_sv_to_int32(sv);
+    if (!val) {
         throw Error("not int32");
     }
+
+    return *val;
 }
 
 int64_t sv_to_int64(const StringView &sv) {
-    try {
-        return std::stoll(std::string(sv.data(), sv.size()));
-    } catch (const std::exception &e) {
+    auto val = try_sv_to_int64(sv);
+    if (!val) {
         throw Error("not int64");
     }
+
+    return *val;
 }
 
 uint32_t sv_to_uint32(const StringView &sv) {
-    try {
-        // TODO: check if it's overflow
-        return std::stoul(std::string(sv.data(), sv.size()));
-    } catch (const std::exception &e) {
+    auto val = try_sv_to_uint32(sv);
+    if (!val) {
         throw Error("not uint32");
     }
+
+    return *val;
 }
 
 uint64_t sv_to_uint64(const StringView &sv) {
-    try {
-        return std::stoull(std::string(sv.data(), sv.size()));
-    } catch (const std::exception &e) {
+    auto val = try_sv_to_uint64(sv);
+    if (!val) {
         throw Error("not uint64");
     }
+
+    return *val;
 }
 
 double sv_to_double(const StringView &sv) {
-    try {
-        return std::stod(std::string(sv.data(), sv.size()));
-    } catch (const std::exception &e) {
+    auto val = try_sv_to_double(sv);
+    if (!val) {
         throw Error("not double");
     }
+
+    return *val;
 }
 
 float sv_to_float(const StringView &sv) {
-    try {
-        return std::stof(std::string(sv.data(), sv.size()));
-    } catch (const std::exception &e) {
+    auto val = try_sv_to_float(sv);
+    if (!val) {
         throw Error("not float");
     }
+
+    return *val;
 }
 
 bool sv_to_bool(const StringView &sv) {
-    bool b = false;
-    auto s = std::string(sv.data(), sv.size());
-    // TODO: make it case insensitive
-    if (s == "true") {
-        b = true;
-    } else if (s == "false") {
-        b = false;
-    } else {
-        try {
-            auto val = std::stoi(s);
-            if (val == 0) {
-                b = false;
-            } else {
-                b = true;
-            }
-        } catch (const std::exception &e) {
-            throw Error("not bool");
-        }
+    auto val = try_sv_to_bool(sv);
+    if (!val) {
+        throw Error("not bool");
     }
 
-    return b;
+    return *val;
 }
 
 std::string sv_to_string(const StringView &sv) {
     return std::string(sv.data(), sv.size());
 }
 
+bool glob_match(const StringView &pattern, const StringView &str) {
+    const auto *p = pattern.data();
+    const auto *p_end = p + pattern.size();
+    const auto *s = str.data();
+    const auto *s_end = s + str.size();
+
+    while (p != p_end) {
+        switch (*p) {
+        case '*':
+            while (p + 1 != p_end && *(p + 1) == '*') {
+                ++p;
+            }
+
+            if (p + 1 == p_end) {
+                return true;
+            }
+
+            // Try to match the rest of the pattern with every suffix of str.
+            for (; ; ++s) {
+                if (glob_match(StringView(p + 1, p_end - p - 1), StringView(s, s_end - s))) {
+                    return true;
+                }
+
+                if (s == s_end) {
+                    return false;
+                }
+            }
+
+        case '?':
+            if (s == s_end) {
+                return false;
+            }
+
+            ++s;
+            break;
+
+        case '[': {
+            if (s == s_end) {
+                return false;
+            }
+
+            ++p;
+            auto negate = (p != p_end && *p == '^');
+            if (negate) {
+                ++p;
+            }
+
+            auto matched = false;
+            for (; p != p_end && *p != ']'; ++p) {
+                if (*p == '\\' && p + 1 != p_end) {
+                    ++p;
+                    matched = matched || (*p == *s);
+                } else if (p + 2 < p_end && *(p + 1) == '-' && *(p + 2) != ']') {
+                    auto low = std::min(*p, *(p + 2));
+                    auto high = std::max(*p, *(p + 2));
+                    matched = matched || (low <= *s && *s <= high);
+                    p += 2;
+                } else {
+                    matched = matched || (*p == *s);
+                }
+            }
+
+            if (p == p_end) {
+                // Unterminated class, e.g. "[abc", take it as the end of pattern.
+                --p;
+            }
+
+            if (matched == negate) {
+                return false;
+            }
+
+            ++s;
+            break;
+        }
+
+        default:
+            if (*p == '\\' && p + 1 != p_end) {
+                // Match the escaped character literally.
+                ++p;
+            }
+
+            if (s == s_end || *p != *s) {
+                return false;
+            }
+
+            ++s;
+            break;
+        }
+
+        ++p;
+    }
+
+    return s == s_end;
+}
+
 bool str_case_equal(const StringView &s1, const StringView &s2) {
     if (s1.size() != s2.size()) {
         return false;
@@ -228,3 +408,65 @@ mode_t file_type(const std::string &file) {
 }
 
 }
+
+namespace {
+
+template <typename Func>
+auto parse_number(const StringView &sv, Func func)
+    -> Optional<decltype(func(nullptr, nullptr))> {
+    using T = decltype(func(nullptr, nullptr));
+
+    if (!is_decimal(sv)) {
+        return {};
+    }
+
+    // strto* functions need a null-terminated string, and most numbers fit in the buffer.
+    char buf[64];
+    std::string str;
+    const char *ptr = nullptr;
+    if (sv.size() < sizeof(buf)) {
+        std::memcpy(buf, sv.data(), sv.size());
+        buf[sv.size()] = '\0';
+        ptr = buf;
+    } else {
+        str.assign(sv.data(), sv.size());
+        ptr = str.c_str();
+    }
+
+    char *end = nullptr;
+    errno = 0;
+    auto val = func(ptr, &end);
+    if (errno == ERANGE || end == ptr || end != ptr + sv.size()) {
+        return {};
+    }
+
+    return Optional<T>(val);
+}
+
+bool is_decimal(const StringView &sv) {
+    if (sv.empty()) {
+        return false;
+    }
+
+    auto first = sv.data()[0];
+    if (first != '-' && first != '.' && !std::isdigit(static_cast<unsigned char>(first))) {
+        return false;
+    }
+
+    // Other characters are checked by strto* functions.
+    for (std::size_t idx = 1; idx != sv.size(); ++idx) {
+        auto ch = sv.data()[idx];
+        if (!std::isdigit(static_cast<unsigned char>(ch))
+                && ch != '.' && ch != 'e' && ch != 'E' && ch != '+' && ch != '-') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool is_negative(const StringView &sv) {
+    return !sv.empty() && sv.data()[0] == '-';
+}
+
+}
@@ -125,6 +125,23 @@ namespace util {
 
 std::string msg_to_json(const gp::Message &msg);
 
+// The following try_sv_to_* functions don't throw, and return an empty Optional,
+// if *sv* is not a valid number, i.e. the whole string must be a number.
+Optional<int32_t> try_sv_to_int32(const StringView &sv);
+
+Optional<int64_t> try_sv_to_int64(const StringView &sv);
+
+Optional<uint32_t> try_sv_to_uint32(const StringView &sv);
+
+Optional<uint64_t> try_sv_to_uint64(const StringView &sv);
+
+Optional<double> try_sv_to_double(const StringView &sv);
+
+Optional<float> try_sv_to_float(const StringView &sv);
+
+Optional<bool> try_sv_to_bool(const StringView &sv);
+
+// The following sv_to_* functions throw Error, if *sv* is not a valid number.
 int32_t sv_to_int32(const StringView &sv);
 
 int64_t sv_to_int64(const StringView &sv);
@@ -139,6 +156,9 @@ float sv_to_float(const StringView &sv);
 
 bool sv_to_bool(const StringView &sv);
 
+// Glob-style pattern matching, the same as the MATCH option of Redis' SCAN command.
+bool glob_match(const StringView &pattern, const StringView &str);
+
 std::string sv_to_string(const StringView &sv);
 
 bool str_case_equal(const StringView &s1, const StringView &s2);
@@ -0,0 +1,102 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "agg_test.h"
+#include "utils.h"
+#include <cmath>
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void AggTest::_run(sw::redis::Redis &r) {
+    auto key = test_key("agg");
+
+    KeyDeleter deleter(r, key);
+
+    REDIS_ASSERT(!r.command<OptionalLongLong>("PB.AGG", key, "Msg", "/arr", "COUNT"),
+            "failed to test pb.agg with non-existent key");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"i" : 1, "arr" : [5, 1, 4, 2, 3, 6, 9, 7, 8, 10]})") == 1,
+            "failed to test pb.agg command");
+
+    REDIS_ASSERT(r.command<long long>("PB.AGG", key, "Msg", "/arr", "COUNT") == 10 &&
+                r.command<long long>("PB.AGG", key, "Msg", "/arr", "SUM") == 55 &&
+                r.command<long long>("PB.AGG", key, "Msg", "/arr", "MIN") == 1 &&
+                r.command<long long>("PB.AGG", key, "Msg", "/arr", "MAX") == 10,
+            "failed to test pb.agg on integer array");
+
+    REDIS_ASSERT(std::stod(r.command<std::string>("PB.AGG", key, "Msg", "/arr", "AVG")) == 5.5 &&
+                std::stod(r.command<std::string>("PB.AGG", key, "Msg", "/arr",
+                        "PERCENTILE", 50)) == 5.5 &&
+                std::stod(r.command<std::string>("PB.AGG", key, "Msg", "/arr",
+                        "PERCENTILE", 100)) == 10,
+            "failed to test pb.agg with avg and percentile");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"vals" : [5.5, 1.5, 4.5, 2.5, 3.5, 6.5, 9.5, 7.5, 8.5, 0.5]})") == 1 &&
+                std::stod(r.command<std::string>("PB.AGG", key, "Msg", "/vals", "MIN")) == 0.5 &&
+                std::stod(r.command<std::string>("PB.AGG", key, "Msg", "/vals", "MAX")) == 9.5,
+            "failed to test pb.agg on double array");
+
+    // NaN propagates, no matter whether it's in the vectorized part or the tail.
+    auto is_nan = [&r, &key](const std::string &op) {
+        auto res = (op == "PERCENTILE") ?
+            r.command<std::string>("PB.AGG", key, "Msg", "/vals", op, 50) :
+            r.command<std::string>("PB.AGG", key, "Msg", "/vals", op);
+        return std::isnan(std::stod(res));
+    };
+
+    for (const auto *vals : {R"({"vals" : [5.5, 1.5, "NaN", 2.5, 3.5, 6.5, 9.5, 7.5, 8.5, 0.5]})",
+                            R"({"vals" : [5.5, 1.5, 4.5, 2.5, 3.5, 6.5, 9.5, 7.5, 8.5, "NaN"]})"}) {
+        REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg", vals) == 1 &&
+                    is_nan("MIN") && is_nan("MAX") && is_nan("SUM") && is_nan("PERCENTILE"),
+                "failed to test pb.agg with NaN");
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.AGG", key, "Msg", "/msg_arr", "COUNT") == 0,
+            "failed to test pb.agg count on message array");
+
+    try {
+        r.command("PB.AGG", key, "Msg", "/i", "SUM");
+        REDIS_ASSERT(false, "failed to test pb.agg on non-array");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command("PB.AGG", key, "Msg", "/arr", "PERCENTILE", 101);
+        REDIS_ASSERT(false, "failed to test pb.agg with invalid percentile");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.CLEAR", key, "Msg", "/arr") == 1 &&
+                r.command<long long>("PB.AGG", key, "Msg", "/arr", "SUM") == 0 &&
+                !r.command<OptionalLongLong>("PB.AGG", key, "Msg", "/arr", "MAX"),
+            "failed to test pb.agg on empty array");
+}
+
+}
+
+}
+
+}
+
+}
@@ -57,6 +57,70 @@ void AppendTest::_run(sw::redis::Redis &r) {
     REDIS_ASSERT(r.command<long long>("PB.GET", key, "Msg",
                 "/arr/0") == 1,
             "failed to test pb.append");
+
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "Msg",
+                "/m/key", "abc") == 3 &&
+            r.command<long long>("PB.APPEND", key, "Msg",
+                "/m/key", "123", "456") == 9 &&
+            r.command<std::string>("PB.GET", key, "Msg", "/m/key") == "abc123456",
+            "failed to test appending map value");
+
+    try {
+        r.command<long long>("PB.APPEND", key, "Msg", "/arr", 5, "not-a-number", 6);
+        REDIS_ASSERT(false, "failed to test appending invalid element");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg", "/arr") == 4,
+            "failed to test all-or-nothing append");
+
+    // Little-endian int32 values: 5 and 6.
+    std::string raw("\x05\x00\x00\x00\x06\x00\x00\x00", 8);
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "--PACKED", "RAW", "Msg",
+                "/arr", raw) == 6 &&
+            r.command<long long>("PB.GET", key, "Msg", "/arr/5") == 6,
+            "failed to test appending raw packed blob");
+
+    // Varint encoded values: 1 and 300.
+    std::string proto("\x01\xac\x02", 3);
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "--PACKED", "PROTO", "Msg",
+                "/arr", proto) == 8 &&
+            r.command<long long>("PB.GET", key, "Msg", "/arr/7") == 300,
+            "failed to test appending proto packed blob");
+
+    try {
+        r.command<long long>("PB.APPEND", key, "--PACKED", "RAW", "Msg",
+                "/arr", std::string("\x01\x02\x03", 3));
+        REDIS_ASSERT(false, "failed to test appending invalid raw packed blob");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg", "/arr") == 8,
+            "failed to test appending invalid raw packed blob");
+
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "--MAXLEN", 5, "Msg",
+                "/arr", 9, 10) == 5 &&
+            r.command<long long>("PB.GET", key, "Msg", "/arr/4") == 10,
+            "failed to test appending with maxlen");
+
+    // Trimmed only if the array exceeds maxlen by a quarter of it, i.e. 2.
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "--MAXLEN", 8, "~", "Msg",
+                "/arr", 11, 12, 13, 14) == 9 &&
+            r.command<long long>("PB.APPEND", key, "--MAXLEN", 8, "~", "Msg",
+                "/arr", 15) == 8 &&
+            r.command<long long>("PB.GET", key, "Msg", "/arr/7") == 15,
+            "failed to test appending with approximate maxlen");
+
+    auto len = r.command<long long>("PB.LEN", key, "Msg", "/arr");
+    try {
+        r.command<long long>("PB.APPEND", key, "Msg", "/arr/[0:1]", 5);
+        REDIS_ASSERT(false, "failed to test appending to array slice");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg", "/arr") == len,
+            "failed to test appending to array slice");
+
     try {
         r.command<long long>("PB.APPEND", key, "Msg",
                 "/i", 2);
@@ -57,6 +57,24 @@ void ClearTest::_run(sw::redis::Redis &r) {
     REDIS_ASSERT(r.command<long long>("PB.CLEAR", key, "Msg", "/sub") == 1 &&
                 r.command<long long>("PB.GET", key, "Msg", "/sub/i") == 0,
             "failed to test clear sub message");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg", "/m/key", "val") == 1 &&
+                r.command<long long>("PB.CLEAR", key, "Msg", "/m/key") == 1 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/m") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/m/key").empty(),
+            "failed to test clear map element");
+
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "Msg", "/arr", 1, 2) == 2,
+            "failed to test pb.clear command");
+
+    try {
+        r.command("PB.CLEAR", key, "Msg", "/arr/[0:1]");
+        REDIS_ASSERT(false, "failed to test clear array slice");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg", "/arr") == 2,
+            "failed to test clear array slice");
 }
 
 }
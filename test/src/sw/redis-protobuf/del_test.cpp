@@ -31,14 +31,30 @@ void DelTest::_run(sw::redis::Redis &r) {
     KeyDeleter deleter(r, key);
 
     REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
-                R"({"i" : 1, "arr" : [1, 2], "m" : {"key" : "val"}})") == 1,
+                R"({"i" : 1, "arr" : [1, 2, 3, 4, 5], "m" : {"key" : "val"},
+                    "msg_arr" : [{"s" : "a"}, {"s" : "b"}]})") == 1,
             "failed to test pb.del command");
 
     REDIS_ASSERT(r.command<long long>("PB.DEL", key, "Msg", "/arr/0") == 1 &&
-                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 1,
+                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 4,
             "failed to test del array element");
+
+    REDIS_ASSERT(r.command<long long>("PB.DEL", key, "Msg", "/arr/[1:3]") == 1 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 2 &&
+                r.command<long long>("PB.GET", key, "Msg", "/arr/1") == 5,
+            "failed to test del array slice");
+
+    REDIS_ASSERT(r.command<long long>("PB.DEL", key, "Msg", "/msg_arr[s=a]") == 1 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/msg_arr") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/msg_arr/0/s") == "b",
+            "failed to test del array element with predicate");
+
+    REDIS_ASSERT(r.command<long long>("PB.DEL", key, "Msg", "/m/key") == 1 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/m") == 0,
+            "failed to test del map element");
+
     /*
-    TODO: support delete whole array and whole map, and map element
+    TODO: support delete whole array and whole map
     REDIS_ASSERT(r.command<long long>("PB.DEL", key, "Msg", "/arr") == 1 &&
                 r.command<long long>("PB.LEN", key, "Msg", "/arr") == 0,
             "failed to test del array");
@@ -0,0 +1,75 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "diff_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void DiffTest::_run(sw::redis::Redis &r) {
+    // Use hash tags, so that it also works with Redis Cluster.
+    auto key1 = test_key("{diff}1");
+    auto key2 = test_key("{diff}2");
+
+    KeyDeleter deleter(r, {key1, key2});
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key1, "Msg",
+                R"({"i" : 1, "sub" : {"s" : "a", "i" : 2}, "arr" : [1, 2]})") == 1 &&
+                r.command<long long>("PB.SET", key2, "Msg",
+                R"({"i" : 1, "sub" : {"s" : "b", "i" : 2}, "m" : {"k" : "v"}})") == 1,
+            "failed to test pb.diff command");
+
+    // Delta that turns key1 into key2.
+    auto delta = r.command<std::vector<std::string>>("PB.DIFF", key2, "Msg", key1);
+    REDIS_ASSERT(delta.size() == 2 && delta[0] == "sub.s,arr,m",
+            "failed to test pb.diff command");
+
+    REDIS_ASSERT(r.command<long long>("PB.APPLYDELTA", key1, "Msg", delta[0], delta[1]) == 3 &&
+                r.command<std::string>("PB.GET", key1, "Msg", "/sub/s") == "b" &&
+                r.command<long long>("PB.GET", key1, "Msg", "/sub/i") == 2 &&
+                r.command<long long>("PB.LEN", key1, "Msg", "/arr") == 0 &&
+                r.command<std::string>("PB.GET", key1, "Msg", "/m/k") == "v",
+            "failed to test pb.applydelta command");
+
+    delta = r.command<std::vector<std::string>>("PB.DIFF", key2, "Msg", key1);
+    REDIS_ASSERT(delta.size() == 2 && delta[0].empty() && delta[1].empty(),
+            "failed to test pb.diff command with equal messages");
+
+    delta = r.command<std::vector<std::string>>("PB.DIFF", key2, "--BLOB", "Msg",
+            R"({"i" : 2, "sub" : {"s" : "b", "i" : 2}, "m" : {"k" : "v"}})");
+    REDIS_ASSERT(delta.size() == 2 && delta[0] == "i",
+            "failed to test pb.diff command with blob");
+
+    try {
+        r.command<long long>("PB.APPLYDELTA", key1, "Msg", "not_exist", "{}");
+        REDIS_ASSERT(false, "failed to test pb.applydelta with invalid mask");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,73 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "incrby_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void IncrbyTest::_run(sw::redis::Redis &r) {
+    auto key = test_key("incrby");
+
+    KeyDeleter deleter(r, key);
+
+    REDIS_ASSERT(r.command<long long>("PB.INCRBY", key, "Msg", "/i", 2) == 2 &&
+                r.command<long long>("PB.INCRBY", key, "Msg", "/i", -5) == -3 &&
+                r.command<long long>("PB.GET", key, "Msg", "/i") == -3,
+            "failed to test pb.incrby command");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"arr" : [1, 2], "sub" : {"i" : 1}})") == 1 &&
+                r.command<long long>("PB.INCRBY", key, "Msg", "/arr/1", 10) == 12 &&
+                r.command<long long>("PB.INCRBY", key, "Msg", "/sub/i", 10) == 11,
+            "failed to test pb.incrby command with array element and sub message");
+
+    try {
+        r.command<long long>("PB.INCRBY", key, "Msg", "/i", 2147483647LL);
+        r.command<long long>("PB.INCRBY", key, "Msg", "/i", 1);
+        REDIS_ASSERT(false, "failed to test pb.incrby with overflow");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.GET", key, "Msg", "/i") == 2147483647LL,
+            "failed to test pb.incrby with overflow");
+
+    try {
+        r.command<long long>("PB.INCRBY", key, "Msg", "/sub/s", 1);
+        REDIS_ASSERT(false, "failed to test pb.incrby with non-integer field");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command<std::string>("PB.INCRBYFLOAT", key, "Msg", "/i", 1.5);
+        REDIS_ASSERT(false, "failed to test pb.incrbyfloat with integer field");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,141 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "index_test.h"
+#include <chrono>
+#include <thread>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void IndexTest::_run(sw::redis::Redis &r) {
+    auto k1 = test_key("index-1");
+    auto k2 = test_key("index-2");
+    auto k3 = test_key("index-3");
+    auto renamed = test_key("index-renamed");
+    auto num_index = test_key("index-i");
+    auto tag_index = test_key("index-s");
+
+    KeyDeleter deleter(r, {k1, k2, k3, renamed});
+
+    r.command("PB.INDEX", "DROP", num_index);
+    r.command("PB.INDEX", "DROP", tag_index);
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", k1, "Msg",
+                R"({"i" : 1, "sub" : {"s" : "a"}})") == 1 &&
+                r.command<long long>("PB.SET", k2, "Msg",
+                R"({"i" : 2, "sub" : {"s" : "b"}})") == 1,
+            "failed to test pb.index command");
+
+    // Other keys of type Msg might exist, so only check keys of this test.
+    auto find = [&r, &k1, &k2, &k3](const std::vector<std::string> &args) {
+        std::vector<std::string> cmd = {"PB.FIND"};
+        cmd.insert(cmd.end(), args.begin(), args.end());
+
+        auto res = r.command(cmd.begin(), cmd.end());
+        REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY, "failed to test pb.find reply");
+
+        std::vector<std::string> result;
+        for (std::size_t idx = 0; idx != res->elements; ++idx) {
+            auto key = reply::parse<std::string>(*(res->element[idx]));
+            if (key == k1 || key == k2 || key == k3) {
+                result.push_back(key);
+            }
+        }
+
+        return result;
+    };
+
+    REDIS_ASSERT(r.command<long long>("PB.INDEX", "CREATE", num_index, "Msg", "/i") >= 2 &&
+                r.command<long long>("PB.INDEX", "CREATE", tag_index, "Msg", "/sub/s", "TAG") >= 2,
+            "failed to test pb.index create");
+
+    REDIS_ASSERT((find({num_index, "1", "2"}) == std::vector<std::string>{k1, k2}) &&
+                (find({num_index, "(1", "+inf"}) == std::vector<std::string>{k2}) &&
+                (find({tag_index, "a"}) == std::vector<std::string>{k1}),
+            "failed to test pb.find");
+
+    // Indexes are updated on modification.
+    REDIS_ASSERT(r.command<long long>("PB.SET", k1, "Msg", "/i", 3) == 1 &&
+                r.command<long long>("PB.SET", k3, "Msg",
+                R"({"i" : 0, "sub" : {"s" : "a"}})") == 1,
+            "failed to test pb.index with modification");
+
+    REDIS_ASSERT((find({num_index, "-inf", "+inf"}) == std::vector<std::string>{k3, k2, k1}) &&
+                (find({tag_index, "a"}).size() == 2),
+            "failed to test pb.find after modification");
+
+    // Indexes are updated on deletion.
+    r.del(k3);
+
+    REDIS_ASSERT((find({num_index, "-inf", "+inf"}) == std::vector<std::string>{k2, k1}) &&
+                (find({tag_index, "a"}) == std::vector<std::string>{k1}),
+            "failed to test pb.find after deletion");
+
+    // Restored keys are found after indexes catch up with the loaded messages.
+    auto dump = r.command<OptionalString>("DUMP", k2);
+    REDIS_ASSERT(dump && r.del(k2) == 1 &&
+                (find({num_index, "-inf", "+inf"}) == std::vector<std::string>{k1}),
+            "failed to test pb.find after deletion");
+
+    r.command("RESTORE", k2, 0, *dump);
+
+    auto restored = false;
+    for (auto idx = 0; idx != 100 && !restored; ++idx) {
+        // Loaded keys are indexed in background.
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        restored = (find({num_index, "-inf", "+inf"}) == std::vector<std::string>{k2, k1});
+    }
+    REDIS_ASSERT(restored, "failed to test pb.find after restore");
+
+    // Renamed keys are not returned with the old name.
+    r.rename(k1, renamed);
+
+    REDIS_ASSERT(find({num_index, "-inf", "+inf"}) == std::vector<std::string>{k2},
+            "failed to test pb.find after rename");
+
+    try {
+        r.command("PB.INDEX", "CREATE", test_key("index-arr"), "Msg", "/arr");
+        REDIS_ASSERT(false, "failed to test pb.index on repeated field");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.INDEX", "DROP", num_index) == 1 &&
+                r.command<long long>("PB.INDEX", "DROP", tag_index) == 1 &&
+                r.command<long long>("PB.INDEX", "DROP", tag_index) == 0,
+            "failed to test pb.index drop");
+
+    try {
+        r.command("PB.FIND", num_index, "-inf", "+inf");
+        REDIS_ASSERT(false, "failed to test pb.find with non-existent index");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,94 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "keys_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void KeysTest::_run(sw::redis::Redis &r) {
+    auto k1 = test_key("keys-1");
+    auto k2 = test_key("keys-2");
+    auto k3 = test_key("keys-3");
+    auto sub_key = test_key("keys-sub");
+
+    KeyDeleter deleter(r, {k1, k2, k3, sub_key});
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", k1, "Msg", "/i", 1) == 1 &&
+                r.command<long long>("PB.SET", k2, "Msg", "/i", 2) == 1 &&
+                r.command<long long>("PB.SET", sub_key, "SubMsg", "/i", 3) == 1,
+            "failed to test pb.keys command");
+
+    // Other keys of type Msg might exist, so only check keys of this test.
+    auto keys = [&r, &k1, &k2, &k3, &sub_key](const std::string &type) {
+        std::vector<std::string> result;
+        std::string cursor = "0";
+        do {
+            auto res = r.command("PB.KEYS", type, cursor, "COUNT", 2);
+            REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 2,
+                    "failed to test pb.keys reply");
+
+            cursor = reply::parse<std::string>(*(res->element[0]));
+
+            const auto &items = *(res->element[1]);
+            REDIS_ASSERT(items.type == REDIS_REPLY_ARRAY && items.elements <= 2,
+                    "failed to test pb.keys with count");
+
+            for (std::size_t idx = 0; idx != items.elements; ++idx) {
+                auto key = reply::parse<std::string>(*(items.element[idx]));
+                if (key == k1 || key == k2 || key == k3 || key == sub_key) {
+                    result.push_back(key);
+                }
+            }
+        } while (cursor != "0");
+
+        return result;
+    };
+
+    // Keys are returned in lexicographical order.
+    REDIS_ASSERT((keys("Msg") == std::vector<std::string>{k1, k2}) &&
+                (keys("SubMsg") == std::vector<std::string>{sub_key}),
+            "failed to test pb.keys");
+
+    // The registry is maintained after it's built.
+    REDIS_ASSERT(r.command<long long>("PB.SET", k3, "Msg", "/i", 3) == 1,
+            "failed to test pb.keys command");
+
+    r.del(k1);
+
+    REDIS_ASSERT((keys("Msg") == std::vector<std::string>{k2, k3}),
+            "failed to test pb.keys after modification");
+
+    try {
+        r.command("PB.KEYS", "Msg", "invalid-cursor");
+        REDIS_ASSERT(false, "failed to test pb.keys with invalid cursor");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -45,6 +45,12 @@ void LenTest::_run(sw::redis::Redis &r) {
     REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg",
                 "/m") == 2,
             "failed to test pb.len with map");
+
+    REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg",
+                "/arr/[1:]") == 2 &&
+            r.command<long long>("PB.LEN", key, "Msg", "/arr/[-5:1]") == 1 &&
+            r.command<long long>("PB.LEN", key, "Msg", "/arr/[2:1]") == 0,
+            "failed to test pb.len with array slice");
 }
 
 }
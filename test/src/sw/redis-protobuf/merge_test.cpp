@@ -53,6 +53,39 @@ void MergeTest::_run(sw::redis::Redis &r) {
     REDIS_ASSERT(r.command<std::string>("PB.GET", key, "Msg",
                 "/m/k2") == "v2",
             "failed to test pb.merge command");
+
+    REDIS_ASSERT(r.command<long long>("PB.MERGE", key, "--MASK", "i,arr", "Msg",
+                R"({"i" : 2, "arr" : [3], "m" : {"k3" : "v3"}})") == 1 &&
+                r.command<long long>("PB.GET", key, "Msg", "/i") == 2 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 1 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/m") == 2,
+            "failed to test pb.merge with mask");
+
+    REDIS_ASSERT(r.command<long long>("PB.MERGE", key, "--MASK", "s", "Msg", "/sub",
+                R"({"s" : "hello", "i" : 1})") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "hello" &&
+                r.command<long long>("PB.GET", key, "Msg", "/sub/i") == 0,
+            "failed to test pb.merge sub message with mask");
+
+    REDIS_ASSERT(r.command<long long>("PB.APPEND", key, "Msg", "/msg_arr",
+                R"({"s" : "a"})", R"({"s" : "b"})") == 2 &&
+                r.command<long long>("PB.MERGE", key, "Msg", "/msg_arr/1",
+                    R"({"i" : 2})") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/msg_arr/1/s") == "b" &&
+                r.command<long long>("PB.GET", key, "Msg", "/msg_arr/1/i") == 2,
+            "failed to test pb.merge array element");
+
+    try {
+        r.command("PB.MERGE", key, "Msg", "/msg_arr/[0:1]", R"({"i" : 3})");
+        REDIS_ASSERT(false, "failed to test pb.merge array slice");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command("PB.MERGE", key, "--MASK", "not-exist", "Msg", R"({"i" : 3})");
+        REDIS_ASSERT(false, "failed to test pb.merge with invalid mask");
+    } catch (const sw::redis::Error &) {
+    }
 }
 
 }
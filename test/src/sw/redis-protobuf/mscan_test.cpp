@@ -0,0 +1,117 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "mscan_test.h"
+#include <algorithm>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void MScanTest::_run(sw::redis::Redis &r) {
+    auto key = test_key("mscan");
+
+    KeyDeleter deleter(r, key);
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"m" : {"k1" : "v1", "k2" : "v2", "k3" : "v3", "k4" : "v4", "x1" : "y1"}})") == 1,
+            "failed to test pb.mscan command");
+
+    auto scan = [&r, &key](const std::string &pattern) {
+        std::vector<std::string> keys;
+        std::string cursor = "0";
+        do {
+            auto res = pattern.empty() ?
+                r.command("PB.MSCAN", key, "Msg", "/m", cursor, "COUNT", 2) :
+                r.command("PB.MSCAN", key, "Msg", "/m", cursor, "COUNT", 2, "MATCH", pattern);
+            REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 2,
+                    "failed to test pb.mscan reply");
+
+            cursor = reply::parse<std::string>(*(res->element[0]));
+
+            const auto &entries = *(res->element[1]);
+            REDIS_ASSERT(entries.type == REDIS_REPLY_ARRAY, "failed to test pb.mscan reply");
+
+            for (std::size_t idx = 0; idx != entries.elements; ++idx) {
+                auto kv = reply::parse<std::pair<std::string, std::string>>(*(entries.element[idx]));
+                keys.push_back(kv.first);
+            }
+        } while (cursor != "0");
+
+        std::sort(keys.begin(), keys.end());
+
+        return keys;
+    };
+
+    REDIS_ASSERT((scan("") == std::vector<std::string>{"k1", "k2", "k3", "k4", "x1"}),
+            "failed to test pb.mscan");
+
+    REDIS_ASSERT((scan("k*") == std::vector<std::string>{"k1", "k2", "k3", "k4"}),
+            "failed to test pb.mscan with match");
+
+    // Modify the map during the iteration, and entries that exist during the whole
+    // iteration should be returned.
+    std::vector<std::string> keys;
+    std::string cursor = "0";
+    auto added = false;
+    do {
+        auto res = r.command("PB.MSCAN", key, "Msg", "/m", cursor, "COUNT", 2);
+        REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 2,
+                "failed to test pb.mscan reply");
+
+        cursor = reply::parse<std::string>(*(res->element[0]));
+
+        const auto &entries = *(res->element[1]);
+        for (std::size_t idx = 0; idx != entries.elements; ++idx) {
+            auto kv = reply::parse<std::pair<std::string, std::string>>(*(entries.element[idx]));
+            keys.push_back(kv.first);
+        }
+
+        if (!added) {
+            // Add enough entries to make the map rehash.
+            for (auto idx = 0; idx != 100; ++idx) {
+                r.command("PB.SET", key, "Msg", "/m/a" + std::to_string(idx), "v");
+            }
+
+            added = true;
+        }
+    } while (cursor != "0");
+
+    for (const auto &k : {"k1", "k2", "k3", "k4", "x1"}) {
+        REDIS_ASSERT(std::count(keys.begin(), keys.end(), k) == 1,
+                "failed to test pb.mscan with modification");
+    }
+
+    auto res = r.command("PB.MSCAN", test_key("mscan-not-exist"), "Msg", "/m", 0);
+    REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 2 &&
+                res->element[0]->type == REDIS_REPLY_STRING &&
+                reply::parse<std::string>(*(res->element[0])) == "0" &&
+                res->element[1]->elements == 0,
+            "failed to test pb.mscan with non-existent key");
+}
+
+}
+
+}
+
+}
+
+}
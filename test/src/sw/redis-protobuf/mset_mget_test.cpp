@@ -0,0 +1,90 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "mset_mget_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void MSetMGetTest::_run(sw::redis::Redis &r) {
+    // Use hash tags, so that it also works with Redis Cluster.
+    auto key1 = test_key("{mset-mget}1");
+    auto key2 = test_key("{mset-mget}2");
+    auto key3 = test_key("{mset-mget}3");
+    // A key beginning with '/' shouldn't be taken as a path.
+    auto key4 = "/" + test_key("{mset-mget}4");
+
+    KeyDeleter deleter(r, {key1, key2, key3, key4});
+
+    auto res = r.command<std::vector<long long>>("PB.MSET", "Msg", "KEYS",
+                key1, R"({"i" : 1, "sub" : {"s" : "a"}})",
+                key2, R"({"i" : 2, "sub" : {"s" : "b"}})");
+    REDIS_ASSERT((res == std::vector<long long>{1, 1}), "failed to test pb.mset command");
+
+    auto vals = r.command<std::vector<OptionalString>>("PB.MGET", "Msg", "/sub/s",
+                "KEYS", key1, key2, key3);
+    REDIS_ASSERT(vals.size() == 3 && vals[0] && *vals[0] == "a" &&
+                vals[1] && *vals[1] == "b" && !vals[2],
+            "failed to test pb.mget command");
+
+    res = r.command<std::vector<long long>>("PB.MSET", "Msg", "/i", "KEYS",
+                key1, 10, key2, 20);
+    REDIS_ASSERT((res == std::vector<long long>{1, 1}) &&
+                r.command<long long>("PB.GET", key1, "Msg", "/i") == 10 &&
+                r.command<long long>("PB.GET", key2, "Msg", "/i") == 20,
+            "failed to test pb.mset command with path");
+
+    auto reply = r.command("PB.MGET", "Msg", "/i", "KEYS", key1, key3);
+    REDIS_ASSERT(reply && reply->type == REDIS_REPLY_ARRAY && reply->elements == 2 &&
+                reply->element[0]->type == REDIS_REPLY_INTEGER &&
+                reply->element[0]->integer == 10 &&
+                reply->element[1]->type == REDIS_REPLY_NIL,
+            "failed to test pb.mget command with non-existent key");
+
+    reply = r.command("PB.MSET", "Msg", "/i", "KEYS",
+                key1, "not-a-number", key2, 30);
+    REDIS_ASSERT(reply && reply->type == REDIS_REPLY_ARRAY && reply->elements == 2 &&
+                reply->element[0]->type == REDIS_REPLY_ERROR &&
+                reply->element[1]->type == REDIS_REPLY_INTEGER &&
+                r.command<long long>("PB.GET", key2, "Msg", "/i") == 30,
+            "failed to test pb.mset command with invalid value");
+
+    res = r.command<std::vector<long long>>("PB.MSET", "Msg", "KEYS", key4, R"({"i" : 4})");
+    auto nums = r.command<std::vector<long long>>("PB.MGET", "Msg", "/i", "KEYS", key4, key1);
+    REDIS_ASSERT((res == std::vector<long long>{1}) &&
+                (nums == std::vector<long long>{4, 10}),
+            "failed to test pb.mset and pb.mget with key beginning with /");
+
+    try {
+        r.command("PB.MGET", "Msg", "/i", key1, key2);
+        REDIS_ASSERT(false, "failed to test pb.mget without KEYS");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
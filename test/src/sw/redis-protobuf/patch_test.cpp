@@ -0,0 +1,84 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "patch_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void PatchTest::_run(sw::redis::Redis &r) {
+    auto key = test_key("patch");
+
+    KeyDeleter deleter(r, key);
+
+    REDIS_ASSERT(r.command<long long>("PB.PATCH", key, "Msg",
+                R"([{"op" : "replace", "path" : "/i", "value" : 1},
+                    {"op" : "add", "path" : "/arr", "value" : 2},
+                    {"op" : "add", "path" : "/m/k", "value" : "v"},
+                    {"op" : "replace", "path" : "/sub",
+                        "value" : {"s" : "str", "i" : 3}}])") == 4 &&
+                r.command<long long>("PB.GET", key, "Msg", "/i") == 1 &&
+                r.command<long long>("PB.GET", key, "Msg", "/arr/0") == 2 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/m/k") == "v" &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "str",
+            "failed to test pb.patch command");
+
+    REDIS_ASSERT(r.command<long long>("PB.PATCH", key, "Msg",
+                R"([{"op" : "increment", "path" : "/sub/i", "value" : 10},
+                    {"op" : "append", "path" : "/sub/s", "value" : "ing"},
+                    {"op" : "remove", "path" : "/arr/0"}])") == 3 &&
+                r.command<long long>("PB.GET", key, "Msg", "/sub/i") == 13 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "string" &&
+                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 0,
+            "failed to test pb.patch command with increment, append and remove");
+
+    try {
+        r.command<long long>("PB.PATCH", key, "Msg",
+                R"([{"op" : "replace", "path" : "/i", "value" : 100},
+                    {"op" : "increment", "path" : "/sub/s", "value" : 1}])");
+        REDIS_ASSERT(false, "failed to test pb.patch with failed operation");
+    } catch (const sw::redis::Error &) {
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.GET", key, "Msg", "/i") == 1,
+            "failed to test pb.patch atomicity");
+
+    // Integers beyond 2^53 are not rounded.
+    REDIS_ASSERT(r.command<long long>("PB.PATCH", key, "Msg",
+                R"([{"op" : "replace", "path" : "/sub/s", "value" : 9007199254740993}])") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "9007199254740993",
+            "failed to test pb.patch with large integer");
+
+    try {
+        r.command<long long>("PB.PATCH", key, "Msg", R"([{"op" : "move", "path" : "/i"}])");
+        REDIS_ASSERT(false, "failed to test pb.patch with unknown op");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,95 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "prepare_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void PrepareTest::_run(sw::redis::Redis &r) {
+    auto key = test_key("prepare");
+
+    KeyDeleter deleter(r, key);
+
+    auto set_handle = r.command<long long>("PB.PREPARE", "SET", "Msg", "/sub/s");
+    REDIS_ASSERT(r.command<long long>("PB.PREPARE", "SET", "Msg", "/sub/s") == set_handle,
+            "failed to test preparing the same operation");
+
+    auto get_handle = r.command<long long>("PB.PREPARE", "GET", "Msg", "/sub/s");
+    REDIS_ASSERT(get_handle != set_handle, "failed to test pb.prepare command");
+
+    REDIS_ASSERT(r.command<long long>("PB.EXEC", set_handle, key, "hello") == 1 &&
+                r.command<std::string>("PB.EXEC", get_handle, key) == "hello" &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "hello",
+            "failed to test pb.exec with prepared set and get");
+
+    REDIS_ASSERT(r.command<std::string>("PB.EXEC_RO", get_handle, key) == "hello",
+            "failed to test pb.exec_ro with prepared get");
+
+    try {
+        r.command<long long>("PB.EXEC_RO", set_handle, key, "hello");
+        REDIS_ASSERT(false, "failed to test pb.exec_ro with prepared set");
+    } catch (const sw::redis::Error &) {
+    }
+
+    auto append_handle = r.command<long long>("PB.PREPARE", "APPEND", "Msg", "/arr");
+    REDIS_ASSERT(r.command<long long>("PB.EXEC", append_handle, key, 1, 2) == 2 &&
+                r.command<long long>("PB.EXEC", append_handle, key, 3) == 3,
+            "failed to test pb.exec with prepared append");
+
+    auto maxlen_handle = r.command<long long>("PB.PREPARE", "APPEND", "--MAXLEN", 2, "Msg", "/arr");
+    REDIS_ASSERT(r.command<long long>("PB.EXEC", maxlen_handle, key, 4) == 2 &&
+                r.command<long long>("PB.GET", key, "Msg", "/arr/0") == 3,
+            "failed to test pb.exec with prepared append with maxlen");
+
+    auto packed_handle = r.command<long long>("PB.PREPARE", "APPEND", "--PACKED", "PROTO",
+            "Msg", "/arr");
+    REDIS_ASSERT(r.command<long long>("PB.EXEC", packed_handle, key, "\x05") == 3 &&
+                r.command<long long>("PB.GET", key, "Msg", "/arr/2") == 5,
+            "failed to test pb.exec with prepared packed append");
+
+    try {
+        r.command<long long>("PB.EXEC", packed_handle, key, "\x01", "\x02");
+        REDIS_ASSERT(false, "failed to test pb.exec with more than one packed blob");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command<long long>("PB.PREPARE", "SET", "Msg", "/not-exist");
+        REDIS_ASSERT(false, "failed to test pb.prepare with invalid path");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command<long long>("PB.EXEC", -1, key, "hello");
+        REDIS_ASSERT(false, "failed to test pb.exec with unknown handle");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,130 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "scan_test.h"
+#include <algorithm>
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void ScanTest::_run(sw::redis::Redis &r) {
+    auto k1 = test_key("scan-1");
+    auto k2 = test_key("scan-2");
+    auto k3 = test_key("scan-3");
+    auto str_key = test_key("scan-str");
+
+    KeyDeleter deleter(r, {k1, k2, k3, str_key});
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", k1, "Msg",
+                R"({"i" : 1, "sub" : {"s" : "a"}})") == 1 &&
+                r.command<long long>("PB.SET", k2, "Msg",
+                R"({"i" : 2, "sub" : {"s" : "b"}})") == 1 &&
+                r.command<long long>("PB.SET", k3, "Msg",
+                R"({"i" : 3, "sub" : {"s" : "c"}})") == 1,
+            "failed to test pb.scan command");
+
+    r.set(str_key, "value");
+
+    auto pattern = test_key("scan-*");
+
+    // Scan all matched keys, and return items of the scan reply.
+    auto scan = [&r, &pattern](const std::vector<std::string> &opts) {
+        std::vector<std::string> items;
+        std::string cursor = "0";
+        do {
+            std::vector<std::string> cmd = {"PB.SCAN", "--FORMAT", "JSON",
+                cursor, "Msg", "MATCH", pattern, "COUNT", "2"};
+            cmd.insert(cmd.end(), opts.begin(), opts.end());
+
+            auto res = r.command(cmd.begin(), cmd.end());
+            REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 2,
+                    "failed to test pb.scan reply");
+
+            cursor = reply::parse<std::string>(*(res->element[0]));
+
+            const auto &matches = *(res->element[1]);
+            REDIS_ASSERT(matches.type == REDIS_REPLY_ARRAY, "failed to test pb.scan reply");
+
+            for (std::size_t idx = 0; idx != matches.elements; ++idx) {
+                const auto &match = *(matches.element[idx]);
+                if (match.type != REDIS_REPLY_ARRAY) {
+                    items.push_back(reply::parse<std::string>(match));
+                    continue;
+                }
+
+                // [key, [value1, value2, ...]]
+                REDIS_ASSERT(match.elements == 2, "failed to test pb.scan with return");
+
+                auto item = reply::parse<std::string>(*(match.element[0]));
+                const auto &values = *(match.element[1]);
+                for (std::size_t i = 0; i != values.elements; ++i) {
+                    const auto &value = *(values.element[i]);
+                    if (value.type == REDIS_REPLY_INTEGER) {
+                        item += ":" + std::to_string(reply::parse<long long>(value));
+                    } else {
+                        item += ":" + reply::parse<std::string>(value);
+                    }
+                }
+
+                items.push_back(item);
+            }
+        } while (cursor != "0");
+
+        std::sort(items.begin(), items.end());
+
+        return items;
+    };
+
+    REDIS_ASSERT((scan({}) == std::vector<std::string>{k1, k2, k3}),
+            "failed to test pb.scan");
+
+    REDIS_ASSERT((scan({"WHERE", "/i", "GE", "2"}) == std::vector<std::string>{k2, k3}),
+            "failed to test pb.scan with where");
+
+    REDIS_ASSERT((scan({"WHERE", "/i", "GE", "2", "/sub/s", "NE", "c"})
+                == std::vector<std::string>{k2}),
+            "failed to test pb.scan with multiple conditions");
+
+    REDIS_ASSERT((scan({"WHERE", "/i", "LT", "3", "RETURN", "/sub/s", "/i"})
+                == std::vector<std::string>{k1 + ":a:1", k2 + ":b:2"}),
+            "failed to test pb.scan with return");
+
+    try {
+        r.command("PB.SCAN", 0, "Msg", "WHERE", "/not-exist", "EQ", 1);
+        REDIS_ASSERT(false, "failed to test pb.scan with invalid condition");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command("PB.SCAN", 0, "NotExistType");
+        REDIS_ASSERT(false, "failed to test pb.scan with invalid type");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -16,6 +16,7 @@
 
 #include "set_get_test.h"
 #include "utils.h"
+#include <algorithm>
 #include <iostream>
 
 namespace sw {
@@ -41,6 +42,14 @@ void SetGetTest::_run(sw::redis::Redis &r) {
                 r.command<long long>("PB.GET", key, "Msg", "/i") == 2,
             "failed to test pb.set and pb.get command");
 
+    for (const auto *val : {" 3", "3 ", "+3", "0x3", "nan", "inf"}) {
+        try {
+            r.command("PB.SET", key, "Msg", "/i", val);
+            REDIS_ASSERT(false, "failed to test pb.set with invalid number");
+        } catch (const sw::redis::Error &) {
+        }
+    }
+
     REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
                 R"({"sub" : {"s" : "hello"}})") == 1 &&
                 r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "hello",
@@ -62,6 +71,17 @@ void SetGetTest::_run(sw::redis::Redis &r) {
                 r.command<std::string>("PB.GET", key, "Msg", "/m/key") == "world",
             "failed to test pb.set and pb.get command");
 
+    REDIS_ASSERT(r.command<long long>("PB.GET", key, "Msg", "/#1") == 123 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/#2/#1") == "hello" &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/#1") == "hello" &&
+                r.command<long long>("PB.GET", key, "Msg", "/#3/1") == 2,
+            "failed to test pb.get command with tag number");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                "/#2/s", "tag") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "tag",
+            "failed to test pb.set command with tag number");
+
     REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
                 R"({"arr" : [4, 5, 6]})") == 1,
             "failed to test pb.set command");
@@ -70,9 +90,131 @@ void SetGetTest::_run(sw::redis::Redis &r) {
     auto tmp = std::vector<long long>{4, 5, 6};
     REDIS_ASSERT(arr == tmp, "failed to test pb.get command");
 
+    arr = r.command<std::vector<long long>>("PB.GET", key, "Msg", "/arr/[1:]");
+    tmp = std::vector<long long>{5, 6};
+    REDIS_ASSERT(arr == tmp, "failed to test pb.get with array slice");
+
+    arr = r.command<std::vector<long long>>("PB.GET", key, "Msg", "/arr/[-2:-1]");
+    tmp = std::vector<long long>{5};
+    REDIS_ASSERT(arr == tmp, "failed to test pb.get with array slice");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"msg_arr" : [{"s" : "a"}, {"s" : "b"}], "m" : {"k1" : "v1", "k2" : "v2"}})") == 1,
+            "failed to test pb.set command");
+
+    auto strs = r.command<std::vector<std::string>>("PB.GET", key, "Msg", "/msg_arr/*/s");
+    REDIS_ASSERT((strs == std::vector<std::string>{"a", "b"}), "failed to test pb.get with wildcard");
+
+    strs = r.command<std::vector<std::string>>("PB.GET", key, "Msg", "/msg_arr/[1:]/s");
+    REDIS_ASSERT((strs == std::vector<std::string>{"b"}), "failed to test pb.get with array slice");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg", "/msg_arr[s=b]/i", 20) == 1 &&
+                r.command<long long>("PB.GET", key, "Msg", "/msg_arr/1/i") == 20 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/msg_arr[i=20]/s") == "b",
+            "failed to test path with predicate");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg", "/msg_arr/0/i", 20) == 1 &&
+                r.command<long long>("PB.SET", key, "Msg", "/msg_arr/1/i", 30) == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/msg_arr[i=30]/s") == "b",
+            "failed to test path with predicate after modification");
+
+    // Make the first element a duplicate, and the first match should be addressed.
+    REDIS_ASSERT(r.command<long long>("PB.GET", key, "Msg", "/msg_arr[s=b]/i") == 30 &&
+                r.command<long long>("PB.SET", key, "Msg", "/msg_arr/0/s", "b") == 1 &&
+                r.command<long long>("PB.GET", key, "Msg", "/msg_arr[s=b]/i") == 20 &&
+                r.command<long long>("PB.SET", key, "Msg", "/msg_arr/0/s", "a") == 1,
+            "failed to test path with predicate matching duplicates");
+
+    try {
+        r.command<std::string>("PB.GET", key, "Msg", "/msg_arr[s=c]/s");
+        REDIS_ASSERT(false, "failed to test path with predicate matching nothing");
+    } catch (const sw::redis::Error &) {
+    }
+
+    // Large arrays are looked up with an index, which is rebuilt after modification.
+    auto arr_key = test_key("set-get-predicate");
+    KeyDeleter arr_deleter(r, arr_key);
+    for (auto idx = 0; idx != 20; ++idx) {
+        r.command("PB.APPEND", arr_key, "Msg", "/msg_arr",
+                R"({"s" : "e)" + std::to_string(idx) + R"(", "i" : )" + std::to_string(idx) + "}");
+    }
+
+    REDIS_ASSERT(r.command<long long>("PB.GET", arr_key, "Msg", "/msg_arr[s=e15]/i") == 15 &&
+                r.command<long long>("PB.SET", arr_key, "Msg", "/msg_arr/3/s", "e15") == 1 &&
+                r.command<long long>("PB.GET", arr_key, "Msg", "/msg_arr[s=e15]/i") == 3,
+            "failed to test path with predicate on large array");
+
+    strs = r.command<std::vector<std::string>>("PB.GET", key, "Msg", "/m/*");
+    std::sort(strs.begin(), strs.end());
+    REDIS_ASSERT((strs == std::vector<std::string>{"v1", "v2"}), "failed to test pb.get with wildcard");
+
+    // The map key "*" is addressed with brackets, instead of being taken as a wildcard.
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg", "/m[*]", "star") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/m[*]") == "star" &&
+                r.command<std::vector<std::string>>("PB.GET", key, "Msg", "/m/*").size() == 3,
+            "failed to test pb.get with map key of wildcard");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"i" : 1, "sub" : {"s" : "hello", "i" : 2}})") == 1,
+            "failed to test pb.set command");
+
+    auto res = r.command("PB.GET", key, "Msg", "/i", "/sub/s", "/sub/i", "/sub/non-exist");
+    REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 4 &&
+                reply::parse<long long>(*(res->element[0])) == 1 &&
+                reply::parse<std::string>(*(res->element[1])) == "hello" &&
+                reply::parse<long long>(*(res->element[2])) == 2 &&
+                res->element[3]->type == REDIS_REPLY_ERROR,
+            "failed to test pb.get with multiple paths");
+
+    res = r.command("PB.GET", key, "Msg", "/i", "/m/non-exist", "/arr/100");
+    REDIS_ASSERT(res && res->type == REDIS_REPLY_ARRAY && res->elements == 3 &&
+                reply::parse<long long>(*(res->element[0])) == 1 &&
+                res->element[1]->type == REDIS_REPLY_ERROR &&
+                res->element[2]->type == REDIS_REPLY_ERROR,
+            "failed to test pb.get with missing map key and array index");
+
     REDIS_ASSERT(r.command<long long>("PB.SET", key, "--NX", "Msg",
                 "/sub/s", "world") == 0,
             "failed to test pb.set and pb.get command");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "--IF", "/i", "EQ", 2, "Msg",
+                "/sub/s", "world") == 0 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "hello",
+            "failed to test pb.set with false condition");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "--IF", "/i", "EQ", 1, "Msg",
+                "/i", 2) == 1 &&
+                r.command<long long>("PB.SET", key, "--IF", "/sub/i", "GT", 1, "Msg",
+                "/sub/s", "world") == 1 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/sub/s") == "world",
+            "failed to test pb.set with true condition");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "--IF", "/m[k]", "EXISTS", "Msg",
+                "/i", 3) == 0 &&
+                r.command<long long>("PB.SET", key, "--IF", "/sub/s", "NE", "world", "Msg",
+                "/i", 3) == 0 &&
+                r.command<long long>("PB.GET", key, "Msg", "/i") == 2,
+            "failed to test pb.set with exists and ne condition");
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"i" : 1, "sub" : {"s" : "hello", "i" : 2}, "arr" : [1, 2]})") == 1 &&
+                r.command<std::string>("PB.GET", key, "--FORMAT", "JSON", "--MASK", "i,sub.s",
+                    "Msg") == R"({"i":1,"sub":{"s":"hello"}})" &&
+                r.command<std::string>("PB.GET", key, "--FORMAT", "JSON", "--MASK", "i",
+                    "Msg", "/sub") == R"({"i":2})",
+            "failed to test pb.get with mask");
+
+    try {
+        r.command("PB.GET", key, "--FORMAT", "JSON", "--MASK", "not-exist", "Msg");
+        REDIS_ASSERT(false, "failed to test pb.get with invalid mask");
+    } catch (const sw::redis::Error &) {
+    }
+
+    try {
+        r.command("PB.GET", key, "--FORMAT", "JSON", "--MASK", "i", "Msg", "/arr");
+        REDIS_ASSERT(false, "failed to test pb.get with mask on non-message");
+    } catch (const sw::redis::Error &) {
+    }
 }
 
 }
@@ -25,6 +25,17 @@
 #include "len_test.h"
 #include "merge_test.h"
 #include "import_test.h"
+#include "mscan_test.h"
+#include "mset_mget_test.h"
+#include "incrby_test.h"
+#include "patch_test.h"
+#include "diff_test.h"
+#include "trim_pop_test.h"
+#include "scan_test.h"
+#include "index_test.h"
+#include "keys_test.h"
+#include "agg_test.h"
+#include "prepare_test.h"
 
 int main() {
     try {
@@ -54,6 +65,39 @@ int main() {
         sw::redis::pb::test::MergeTest merge_test(r);
         merge_test.run();
 
+        sw::redis::pb::test::MScanTest mscan_test(r);
+        mscan_test.run();
+
+        sw::redis::pb::test::MSetMGetTest mset_mget_test(r);
+        mset_mget_test.run();
+
+        sw::redis::pb::test::IncrbyTest incrby_test(r);
+        incrby_test.run();
+
+        sw::redis::pb::test::PatchTest patch_test(r);
+        patch_test.run();
+
+        sw::redis::pb::test::DiffTest diff_test(r);
+        diff_test.run();
+
+        sw::redis::pb::test::TrimPopTest trim_pop_test(r);
+        trim_pop_test.run();
+
+        sw::redis::pb::test::ScanTest scan_test(r);
+        scan_test.run();
+
+        sw::redis::pb::test::IndexTest index_test(r);
+        index_test.run();
+
+        sw::redis::pb::test::KeysTest keys_test(r);
+        keys_test.run();
+
+        sw::redis::pb::test::AggTest agg_test(r);
+        agg_test.run();
+
+        sw::redis::pb::test::PrepareTest prepare_test(r);
+        prepare_test.run();
+
         sw::redis::pb::test::ImportTest import_test(r);
         import_test.run();
 
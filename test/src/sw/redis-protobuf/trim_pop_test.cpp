@@ -0,0 +1,90 @@
+/**************************************************************************
+   Copyright (c) 2022 sewenew
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "trim_pop_test.h"
+#include "utils.h"
+
+namespace sw {
+
+namespace redis {
+
+namespace pb {
+
+namespace test {
+
+void TrimPopTest::_run(sw::redis::Redis &r) {
+    auto key = test_key("trim-pop");
+
+    KeyDeleter deleter(r, key);
+
+    REDIS_ASSERT(r.command<long long>("PB.SET", key, "Msg",
+                R"({"arr" : [1, 2, 3, 4, 5, 6, 7, 8],
+                    "msg_arr" : [{"s" : "a"}, {"s" : "b"}, {"s" : "c"}]})") == 1,
+            "failed to test pb.trim command");
+
+    REDIS_ASSERT(r.command<long long>("PB.TRIM", key, "Msg", "/arr", 1, -2) == 6 &&
+                r.command<long long>("PB.GET", key, "Msg", "/arr/0") == 2 &&
+                r.command<long long>("PB.GET", key, "Msg", "/arr/5") == 7,
+            "failed to test pb.trim command");
+
+    REDIS_ASSERT(r.command<long long>("PB.POP", key, "Msg", "/arr") == 2 &&
+                r.command<long long>("PB.POP", key, "Msg", "/arr", "RIGHT") == 7 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 4,
+            "failed to test pb.pop command");
+
+    auto vals = r.command<std::vector<long long>>("PB.POP", key, "Msg", "/arr", "RIGHT", 3);
+    REDIS_ASSERT((vals == std::vector<long long>{6, 5, 4}) &&
+                r.command<long long>("PB.LEN", key, "Msg", "/arr") == 1,
+            "failed to test pb.pop command with count");
+
+    auto strs = r.command<std::vector<std::string>>("PB.POP", key, "--FORMAT", "JSON", "Msg",
+            "/msg_arr", "LEFT", 2);
+    REDIS_ASSERT(strs.size() == 2 &&
+                r.command<std::string>("PB.GET", key, "Msg", "/msg_arr/0/s") == "c",
+            "failed to test pb.pop command with message array");
+
+    REDIS_ASSERT(r.command<long long>("PB.TRIM", key, "Msg", "/msg_arr", 1, 0) == 0 &&
+                r.command<long long>("PB.LEN", key, "Msg", "/msg_arr") == 0,
+            "failed to test pb.trim command with empty range");
+
+    auto reply = r.command("PB.POP", key, "Msg", "/msg_arr");
+    REDIS_ASSERT(reply && reply->type == REDIS_REPLY_NIL,
+            "failed to test pb.pop command with empty array");
+
+    try {
+        r.command("PB.POP", key, "Msg", "/msg_arr/9/arr", 2);
+        REDIS_ASSERT(false, "failed to test pb.pop command with out-of-range index");
+    } catch (const sw::redis::Error &) {
+    }
+
+    // The error above should be the only reply, and the connection is still in sync.
+    REDIS_ASSERT(r.command<long long>("PB.LEN", key, "Msg", "/arr") == 1,
+            "failed to test pb.pop command with out-of-range index");
+
+    try {
+        r.command<long long>("PB.TRIM", key, "Msg", "/m", 0, 1);
+        REDIS_ASSERT(false, "failed to test pb.trim command with map");
+    } catch (const sw::redis::Error &) {
+    }
+}
+
+}
+
+}
+
+}
+
+}